@@ -0,0 +1,109 @@
+#ifndef BULK_TRANSFER_H
+#define BULK_TRANSFER_H
+
+/**
+ * @file    bulk_transfer.h
+ * @brief   Envio de objetos grandes como sequência de mensagens SLOW.
+ *
+ * O FO de 8 bits limita uma mensagem a MAX_FRAGS fragmentos (~360 KB).
+ * Um BulkTransfer corta o objeto em mensagens desse tamanho, cada uma
+ * com seu FID, e as emenda na janela deslizante: a próxima começa assim
+ * que todos os fragmentos da anterior saíram, sem esperar os ACKs.
+ */
+
+#include "network.h"
+#include "sender.h"
+#include "session.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * @class BulkTransfer
+ * @brief Transmite um buffer ou o conteúdo de um descritor até o fim.
+ *
+ * A origem pode ser memória (o buffer precisa viver até o fim do envio)
+ * ou um descritor lido em blocos de uma mensagem, reutilizando o mesmo
+ * buffer: a Network guarda sua própria cópia de cada fragmento para as
+ * retransmissões.
+ */
+class BulkTransfer {
+public:
+    /**
+     * @brief Andamento do envio.
+     */
+    struct Progress {
+        uint64_t total = 0;    // Tamanho do objeto (0 se desconhecido, ex.: pipe)
+        uint64_t sent = 0;     // Bytes já emitidos (1ª transmissão)
+        uint64_t acked = 0;    // Bytes confirmados pelo peer
+        uint32_t messages = 0; // Mensagens (FIDs) iniciadas
+        uint64_t elapsedMs = 0;
+
+        /**
+         * @brief Vazão confirmada em MB/s.
+         */
+        double mbps() const { return elapsedMs ? acked / 1e3 / double(elapsedMs) : 0; }
+    };
+    using ProgressFn = std::function<void(const Progress&)>;
+
+    BulkTransfer(Network& net, const sockaddr_in& dst, Session& sess);
+
+    /**
+     * @brief Registra o callback de progresso, chamado no máximo a cada
+     *        `intervalMs` e uma última vez ao terminar.
+     */
+    void onProgress(ProgressFn fn, uint64_t intervalMs = 500);
+
+    /**
+     * @brief Envia `len` bytes da memória.
+     * @return true se tudo foi confirmado.
+     */
+    bool send(const uint8_t* data, size_t len);
+    /**
+     * @brief Envia o conteúdo de `fd` até EOF.
+     * @return true se tudo foi lido e confirmado.
+     */
+    bool send(int fd);
+    /**
+     * @brief Envia um arquivo direto do mapeamento (mmap + leitura
+     *        sequencial), sem copiá-lo para a memória do processo.
+     *
+     * Se o arquivo não puder ser mapeado (ex.: FIFO), lê pelo descritor.
+     * @return true se tudo foi confirmado.
+     */
+    bool sendFile(const char* path);
+
+    const Progress& progress() const { return prog; }
+
+private:
+    bool run();
+    bool nextMessage();
+    bool pump();
+    void report(bool last);
+
+    static constexpr int MAX_IDLE = 20; // Recepções vazias seguidas antes de desistir
+
+    Network& net;
+    Session& sess;
+    Sender tx;
+    std::vector<SlowPacketView> rx; // ACKs drenados por pump
+
+    const uint8_t* src = nullptr; // Origem em memória
+    size_t srcLen = 0;
+    size_t srcOff = 0;
+    int fd = -1;                  // ou origem em descritor
+    bool readErr = false;
+    std::vector<uint8_t> chunk;   // Mensagem lida do descritor
+
+    Progress prog;
+    uint64_t base = 0; // Bytes das mensagens anteriores à atual
+    uint64_t dropBase = 0; // Network::droppedBytes() no início de run()
+    uint64_t start = 0;
+    uint64_t lastReport = 0;
+    uint64_t interval = 500;
+    ProgressFn progressFn;
+};
+
+#endif
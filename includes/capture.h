@@ -0,0 +1,114 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/**
+ * @file    capture.h
+ * @brief   Captura binária dos datagramas SLOW (formato pcap) e leitura
+ *          de capturas.
+ *
+ * O arquivo é um pcap com resolução de nanossegundos e link type
+ * USER0: cada registro leva um pseudo-cabeçalho de 8 bytes (direção e
+ * endereço do peer) seguido do datagrama cru (cabeçalho de 32 bytes e
+ * payload). Os tempos vêm do relógio monotônico, não do relógio de
+ * parede: servem para medir intervalos, não para datar o tráfego.
+ */
+
+#include "transport.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * @class Capture
+ * @brief Acrescenta datagramas a um arquivo de captura com escrita bufferizada.
+ *
+ * Pensada para ficar sempre ligada: cada registro é só um memcpy para
+ * o buffer, que vai ao disco quando enche, em flush() ou no fechamento.
+ * Pode ser compartilhada por vários Networks da mesma thread.
+ */
+class Capture {
+public:
+    enum Dir : uint8_t { Tx = 0, Rx = 1 };
+
+    static constexpr uint32_t MAGIC_NS = 0xa1b23c4d; // pcap com tempos em ns
+    static constexpr uint32_t LINKTYPE_USER0 = 147;
+    static constexpr size_t PSEUDO_SIZE = 8; // direção, reservado, porta, IPv4
+
+    Capture() = default;
+    ~Capture() { close(); }
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+
+    /**
+     * @brief Cria (ou trunca) o arquivo e grava o cabeçalho global.
+     */
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * @brief Registra um datagrama de saída (iovecs de cabeçalho e payload).
+     */
+    void record(Dir dir, const sockaddr_in& peer, const OutDatagram& d);
+    /**
+     * @brief Registra um datagrama contíguo (ex.: recebido).
+     */
+    void record(Dir dir, const sockaddr_in& peer, const uint8_t* data, size_t len);
+    /**
+     * @brief Escreve o que estiver no buffer.
+     */
+    void flush();
+
+    uint64_t records() const { return count; }
+
+private:
+    static constexpr size_t BUF_SIZE = 1 << 16;
+
+    void begin(Dir dir, const sockaddr_in& peer, size_t len);
+    void append(const void* p, size_t n);
+
+    int fd = -1;
+    std::vector<uint8_t> buf;
+    uint64_t count = 0;
+};
+
+/**
+ * @class CaptureReader
+ * @brief Percorre os registros de um arquivo gravado por Capture.
+ */
+class CaptureReader {
+public:
+    /**
+     * @brief Um registro; `data` vale até a próxima chamada de next().
+     */
+    struct Entry {
+        uint64_t ns = 0;
+        Capture::Dir dir = Capture::Tx;
+        sockaddr_in peer{};
+        const uint8_t* data = nullptr;
+        size_t len = 0;
+    };
+
+    CaptureReader() = default;
+    ~CaptureReader() { if (f) fclose(f); }
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    /**
+     * @brief Abre e valida o cabeçalho global (magic e link type).
+     */
+    bool open(const char* path);
+    /**
+     * @return false no fim do arquivo ou num registro truncado.
+     */
+    bool next(Entry& e);
+
+private:
+    FILE* f = nullptr;
+    bool swapped = false; // gravado com a outra ordem de bytes
+    std::vector<uint8_t> rec;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef CONGESTION_H
+#define CONGESTION_H
+
+/**
+ * @file    congestion.h
+ * @brief   Controle de congestionamento plugável para o envio SLOW.
+ *
+ * A janela efetiva de envio é min(cwnd, remoteWindow): a janela do peer
+ * protege o receptor, a cwnd protege o caminho. A Network alimenta o
+ * controlador com eventos de ACK, de perda (fast retransmit) e de
+ * timeout (RTO); o algoritmo pode ser trocado em tempo de execução.
+ */
+
+#include "slow.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @class CongestionController
+ * @brief Interface comum aos algoritmos de controle de congestionamento.
+ *
+ * Todas as janelas são em bytes; MSS corresponde a MAX_DATA.
+ */
+class CongestionController {
+public:
+    static constexpr uint32_t MSS = MAX_DATA;
+    static constexpr uint32_t MAX_CWND = 1u << 30; // Teto da cwnd (B), bem acima de qualquer janela anunciável
+
+    virtual ~CongestionController() = default;
+    virtual const char* name() const = 0;
+    /**
+     * @brief Bytes novos confirmados por um ACK cumulativo.
+     * @param acked Bytes liberados.
+     * @param now   Instante do ACK (ms).
+     * @param srtt  RTT suavizado corrente (ms, 0 se desconhecido).
+     */
+    virtual void onAck(uint32_t acked, uint64_t now, double srtt) = 0;
+    /**
+     * @brief Perda detectada por ACKs duplicados (uma vez por recuperação).
+     */
+    virtual void onLoss(uint64_t now) = 0;
+    /**
+     * @brief Estouro de RTO: o caminho provavelmente esvaziou.
+     */
+    virtual void onTimeout(uint64_t now) = 0;
+    /**
+     * @brief Tudo confirmado e nada mais em voo: o fluxo ficou ocioso ou
+     *        limitado pela aplicação até o próximo envio.
+     */
+    virtual void onIdle(uint64_t) {}
+
+    uint32_t cwnd() const { return cw; }
+    uint32_t ssthresh() const { return ssth; }
+
+protected:
+    uint32_t cw = 4 * MSS;
+    uint32_t ssth = UINT32_MAX;
+};
+
+/**
+ * @class NewRenoController
+ * @brief AIMD clássico: slow start, +1 MSS por RTT, metade na perda.
+ */
+class NewRenoController : public CongestionController {
+public:
+    const char* name() const override { return "reno"; }
+    void onAck(uint32_t acked, uint64_t now, double srtt) override;
+    void onLoss(uint64_t now) override;
+    void onTimeout(uint64_t now) override;
+};
+
+/**
+ * @class CubicController
+ * @brief CUBIC (RFC 9438): crescimento cúbico a partir do último W_max,
+ *        com região amigável ao Reno para RTTs curtos.
+ */
+class CubicController : public CongestionController {
+public:
+    const char* name() const override { return "cubic"; }
+    void onAck(uint32_t acked, uint64_t now, double srtt) override;
+    void onLoss(uint64_t now) override;
+    void onTimeout(uint64_t now) override;
+    void onIdle(uint64_t now) override;
+
+private:
+    static constexpr double C = 0.4;
+    static constexpr double BETA = 0.7;
+
+    double wMax = 0;      // cwnd (em MSS) antes da última redução
+    double k = 0;         // tempo (s) até voltar a wMax
+    double wEst = 0;      // estimativa Reno (em MSS)
+    uint64_t epoch = 0;   // início da época de crescimento (ms), 0 = nenhuma
+    void reduce();
+};
+
+/**
+ * @brief Cria um controlador pelo nome ("reno" ou "cubic").
+ * @return nullptr se o nome for desconhecido.
+ */
+std::unique_ptr<CongestionController> makeCongestionController(const std::string& name);
+
+#endif
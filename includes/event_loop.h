@@ -0,0 +1,221 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+/**
+ * @file    event_loop.h
+ * @brief   Laço de eventos (epoll + timerfd) com várias sessões SLOW num só socket.
+ *
+ * Transforma o cliente em biblioteca: em vez de bloquear em
+ * receivePacket, cada sessão vira uma Connection com máquina de estados
+ * (handshake, envio, revive, disconnect) dirigida por callbacks. Todas
+ * dividem o mesmo backend Transport; os datagramas recebidos são
+ * entregues à sessão certa pelo SID de 16 bytes do cabeçalho.
+ */
+
+#include "network.h"
+#include "reassembler.h"
+#include "sender.h"
+#include "session.h"
+#include "timer_wheel.h"
+#include "transport.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+
+class EventLoop;
+
+/**
+ * @struct Connection
+ * @brief Uma sessão SLOW gerenciada pelo EventLoop.
+ *
+ * Cada conexão tem seu próprio Network (fila de retransmissão, RTT,
+ * cwnd), mas o Transport é compartilhado.
+ */
+struct Connection {
+    enum class State { Handshake, Open, Reviving, Closing, Closed };
+
+    /**
+     * @brief Callbacks da aplicação; todos são opcionais.
+     */
+    struct Handlers {
+        std::function<void(Connection&)> onOpen; // handshake ou revive concluído
+        std::function<void(Connection&, size_t)> onSent; // mensagem inteira confirmada (bytes)
+        std::function<void(Connection&, bool)> onClosed; // encerrada (true = disconnect confirmado)
+        std::function<void(Connection&, const SlowPacketView&)> onPacket; // todo pacote recebido (view válida só no callback)
+        std::function<void(Connection&, ByteSpan)> onMessage; // mensagem do peer já remontada
+    };
+
+    Connection(uint32_t id, const sockaddr_in& srv, Handlers h);
+
+    uint32_t id; // Identificador local (chave na roda de timers)
+    State state = State::Handshake;
+    Session sess;
+    Network net;
+    Sender tx;
+    Handlers h;
+    void* user = nullptr; // Livre para a aplicação
+
+private:
+    friend class EventLoop;
+    std::deque<std::vector<uint8_t>> outbox; // Mensagens aguardando envio (a da frente está em curso)
+    bool sending = false;
+    uint64_t deadline = TimerWheel::NONE; // Timeout do estado corrente ou próximo probe
+    uint64_t armed = TimerWheel::NONE; // Menor deadline já agendado na roda
+    uint64_t keepAt = TimerWheel::NONE; // Keep-alive agendado na roda de ociosidade
+};
+
+/**
+ * @class EventLoop
+ * @brief Multiplexa muitas Connections sobre um socket UDP.
+ *
+ * A lógica fica em dispatch() (um datagrama) e onTimer() (deadlines
+ * vencidos), independentes do epoll: runOnce() apenas espera com
+ * epoll_wait sobre o descritor do backend e um timerfd armado no
+ * próximo deadline de todas as sessões.
+ *
+ * O SETUP do servidor chega com um SID ainda desconhecido; ele é
+ * atribuído à conexão em handshake mais antiga (ordem FIFO). Os dados
+ * enviados pelo servidor passam por um Reassembler único, cujo espaço
+ * livre é a janela anunciada por todas as conexões; `rxSlots` deve
+ * comportar uma mensagem máxima por conexão recebendo ao mesmo tempo.
+ *
+ * Conexões abertas e ociosas recebem um pure-ACK na metade do STTL
+ * (ms), e um revive em segundo plano se nada chegar até o STTL vencer.
+ * Esses keep-alives ficam numa roda própria, de resolução grossa, e os
+ * que vencem dentro da mesma folga saem num único lote de envio.
+ */
+class EventLoop {
+public:
+    static constexpr uint64_t STATE_TIMEOUT_MS = 8000; // Limite para handshake/revive/disconnect
+    static constexpr uint64_t KEEPALIVE_SLACK_MS = 250; // Antecipação máxima para agrupar keep-alives
+
+    explicit EventLoop(const sockaddr_in& server, size_t rxSlots = Reassembler::DEFAULT_SLOTS);
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Abre o backend de E/S e registra socket e timerfd no epoll.
+     * @param backend Nome do backend ("socket" ou, se compilado, "uring").
+     */
+    bool open(const std::string& backend = "socket");
+    /**
+     * @brief Usa um backend já aberto, sem epoll: quem dirige o laço
+     *        chama poll() (ex.: o Simulator, com relógio virtual).
+     */
+    void attach(std::shared_ptr<Transport> t) { io = std::move(t); }
+    /**
+     * @brief Inicia o 3-way handshake de uma nova sessão.
+     *
+     * A janela anunciada é o espaço livre do Reassembler compartilhado.
+     * @return a conexão, válida até release().
+     */
+    Connection* connect(Connection::Handlers h);
+    /**
+     * @brief Descarta a conexão (sem avisar o servidor) ao fim da iteração.
+     */
+    void release(Connection& c);
+    /**
+     * @brief Enfileira uma mensagem; fragmentos saem conforme a janela.
+     *
+     * Mensagens acima de Sender::maxMessage() são descartadas ao chegar
+     * a vez delas.
+     * @return false se a conexão não estiver aberta nem em handshake/revive.
+     */
+    bool send(Connection& c, std::vector<uint8_t> msg);
+    /**
+     * @brief Pede o encerramento; onClosed(true) quando o servidor confirmar.
+     */
+    void disconnect(Connection& c);
+    /**
+     * @brief Tenta reviver uma sessão encerrada (mesmo SID); onOpen se aceito.
+     */
+    void revive(Connection& c, const std::string& payload = "revive");
+
+    /**
+     * @brief Processa um datagrama já lido do backend.
+     */
+    void dispatch(const Datagram& dg);
+    /**
+     * @brief Trata todos os deadlines vencidos até `now`.
+     */
+    void onTimer(uint64_t now);
+    /**
+     * @brief Uma iteração: espera até `timeoutMs` (-1 = sem limite) e
+     *        processa o que estiver pronto.
+     * @return quantidade de eventos tratados, ou -1 em erro.
+     */
+    int runOnce(int timeoutMs = -1);
+    /**
+     * @brief Sem esperar: entrega o que o backend já tem e trata os
+     *        deadlines vencidos até `now`.
+     * @return datagramas entregues.
+     */
+    size_t poll(uint64_t now);
+    /**
+     * @brief Menor deadline agendado entre todas as conexões (ms),
+     *        keep-alives incluídos.
+     */
+    uint64_t nextDeadline() const { return std::min(wheel.nextDeadline(), idle.nextDeadline()); }
+    /**
+     * @brief Roda até stop() ou até não restar conexão ativa.
+     */
+    void run();
+    void stop() { running = false; }
+    /**
+     * @brief Captura o tráfego das conexões criadas daqui em diante.
+     */
+    void setCapture(Capture* c) { cap = c; }
+    /**
+     * @brief Liga/desliga os keep-alives automáticos (ligados por padrão).
+     */
+    void setKeepAlive(bool on) { keepAlive = on; }
+
+    size_t size() const { return conns.size(); }
+    size_t active() const { return live; } // Conexões fora do estado Closed
+
+private:
+    struct SidHash {
+        size_t operator()(const std::array<uint8_t, UUID_SIZE>& s) const;
+    };
+
+    void step(Connection& c, const SlowPacketView& pkt);
+    void pump(Connection& c);
+    void setState(Connection& c, Connection::State s);
+    void close(Connection& c, bool graceful);
+    void arm(Connection& c);
+    void keep(Connection& c);
+    void keepAlives(uint64_t now);
+    void rearmTimer();
+    size_t drain();
+    void reap();
+
+    sockaddr_in srv;
+    std::shared_ptr<Transport> io;
+    int epfd = -1;
+    int tfd = -1;
+    bool running = false;
+    bool keepAlive = true;
+    uint32_t nextId = 1;
+    size_t live = 0;
+    std::unordered_map<uint32_t, std::unique_ptr<Connection>> conns;
+    std::unordered_map<std::array<uint8_t, UUID_SIZE>, Connection*, SidHash> bySid;
+    std::deque<uint32_t> handshaking; // Ordem dos CONNECT sem SETUP
+    std::vector<uint32_t> released; // Liberadas ao fim da iteração
+    Reassembler rxq; // Remontagem compartilhada dos dados recebidos
+    Capture* cap = nullptr; // Captura compartilhada (opcional)
+    TimerWheel wheel; // Próximo deadline de cada conexão
+    TimerWheel idle{KEEPALIVE_SLACK_MS, 512}; // Keep-alives das conexões abertas
+    std::vector<uint32_t> expired;
+    std::vector<std::array<uint8_t, HDR_SIZE>> keepHdr; // Lote de keep-alives a enviar
+    std::vector<Datagram> rx;
+};
+
+#endif
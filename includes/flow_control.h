@@ -0,0 +1,83 @@
+#ifndef FLOW_CONTROL_H
+#define FLOW_CONTROL_H
+
+/**
+ * @file    flow_control.h
+ * @brief   Persist timer para janela zero e ACKs atrasados/de carona.
+ *
+ * Só decide *quando*: a Network é quem monta e envia os pure-ACKs.
+ *
+ * Janela zero: com a janela do peer fechada (ou menor que o próximo
+ * fragmento) e nada em voo, nenhum ACK chegaria sozinho. O persist timer
+ * manda um probe depois de um RTO e dobra o intervalo a cada probe
+ * respondido com uma janela que ainda não comporta o fragmento (até
+ * MAX_PERSIST_MS), em vez de sondar em laço.
+ *
+ * ACKs: dados recebidos não são confirmados na hora. O ACK pega carona
+ * no próximo pacote com dados (todo pacote leva ACK e acknum) ou sai
+ * como pure-ACK depois de ACK_DELAY_MS; a cada ACK_EVERY pacotes com
+ * dados ainda sem confirmação ele sai de imediato, como na RFC 1122.
+ */
+
+#include <cstdint>
+
+/**
+ * @class FlowControl
+ * @brief Estado do persist timer e do ACK pendente de uma sessão.
+ */
+class FlowControl {
+public:
+    static constexpr uint64_t NONE = UINT64_MAX;
+    static constexpr uint64_t ACK_DELAY_MS = 40;     // Atraso máximo de um ACK
+    static constexpr int ACK_EVERY = 2;               // Pacotes com dados por ACK imediato
+    static constexpr uint64_t MAX_PERSIST_MS = 8000;  // Teto do intervalo entre probes
+
+    /**
+     * @brief Janela menor que `need` bytes sem nada em voo: arma o persist
+     *        timer em um RTO, se ainda não estiver armado.
+     */
+    void blocked(uint64_t now, uint64_t rto, uint32_t need);
+    /**
+     * @brief O peer anunciou `window`: se comporta o fragmento que
+     *        esperava, desarma e zera o backoff.
+     */
+    void opened(uint32_t window);
+    /**
+     * @brief Venceu a hora do probe? Se sim, já agenda o próximo.
+     */
+    bool probeDue(uint64_t now);
+    bool persisting() const { return persistAt != NONE; }
+
+    /**
+     * @brief Chegou um pacote com dados a confirmar.
+     */
+    void received(uint64_t now);
+    /**
+     * @brief Um ACK a confirmar sem contar como dado (ex.: o do handshake).
+     */
+    void defer(uint64_t now);
+    /**
+     * @brief Saiu um pacote com o acknum corrente (pure-ACK ou carona).
+     */
+    void acked();
+    bool ackPending() const { return ackAt != NONE; }
+    /**
+     * @brief O ACK pendente já deve sair (prazo vencido ou ACK_EVERY).
+     */
+    bool ackDue(uint64_t now) const { return ackPending() && (unacked >= ACK_EVERY || now >= ackAt); }
+
+    /**
+     * @brief Próximo instante em que probeDue/ackDue podem mudar, ou NONE.
+     */
+    uint64_t nextDeadline() const { return persistAt < ackAt ? persistAt : ackAt; }
+    void reset();
+
+private:
+    uint64_t persistAt = NONE; // Próximo probe de janela zero
+    uint64_t interval = 0;     // Intervalo corrente entre probes (ms)
+    uint32_t need = 1;         // Janela mínima que destrava o envio (B)
+    uint64_t ackAt = NONE;     // Prazo do ACK pendente
+    int unacked = 0;           // Pacotes com dados ainda sem ACK
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef IMPAIRMENT_H
+#define IMPAIRMENT_H
+
+/**
+ * @file    impairment.h
+ * @brief   Backend decorador que degrada o tráfego: perda (aleatória ou
+ *          em rajadas), atraso com jitter, reordenação, duplicação e
+ *          limite de banda, nas duas direções.
+ *
+ * Fica entre a Network e o backend real, sem root nem netem: com a
+ * mesma semente e a mesma sequência de pacotes, as decisões são as
+ * mesmas. Os pacotes atrasados são copiados para filas ordenadas pelo
+ * instante de saída, liberadas nas chamadas de send/wait/recv.
+ */
+
+#include "transport.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * @class ImpairedLink
+ * @brief Um sentido de um enlace degradado, com tempo explícito (µs).
+ *
+ * Não sabe de relógio nem de socket: admit() decide o destino de um
+ * pacote no instante dado e pop() devolve os que já venceram. É a peça
+ * comum ao ImpairedTransport (relógio real) e ao Simulator (virtual).
+ */
+class ImpairedLink {
+public:
+    static constexpr uint64_t NONE = UINT64_MAX;
+
+    /**
+     * @brief Perfil do enlace.
+     *
+     * A perda segue o modelo de Gilbert-Elliott: com `burst` = 1 cada
+     * pacote é perdido com probabilidade `loss`; com `burst` > 1 as
+     * perdas vêm em rajadas de tamanho médio `burst`, mantendo a taxa
+     * média `loss`.
+     */
+    struct Config {
+        double loss = 0;        // Fração perdida (0..1)
+        double burst = 1;       // Tamanho médio das rajadas de perda
+        uint64_t delayUs = 0;   // Atraso fixo
+        uint64_t jitterUs = 0;  // Atraso extra uniforme em [0, jitter]
+        double reorder = 0;     // Fração retida por mais um atraso (sai depois das seguintes)
+        double duplicate = 0;   // Fração entregue duas vezes
+        uint64_t rateBps = 0;   // Banda em bits/s (0 = sem limite)
+        size_t queue = 1000;    // Pacotes na fila do enlace antes de descartar
+    };
+
+    struct Counters {
+        uint64_t passed = 0, lost = 0, duplicated = 0, reordered = 0, overflow = 0;
+    };
+
+    struct Packet {
+        uint64_t due;   // µs
+        uint64_t order; // desempate: ordem de chegada
+        sockaddr_in addr;
+        std::vector<uint8_t> bytes;
+        bool operator>(const Packet& o) const { return due != o.due ? due > o.due : order > o.order; }
+    };
+
+    ImpairedLink(const Config& cfg, uint64_t seed) : cfg(cfg), rng(seed) {}
+
+    /**
+     * @brief Copia um pacote para o enlace (ou o descarta) no instante `now`.
+     */
+    void admit(const sockaddr_in& addr, const iovec* iov, size_t iovcnt, uint64_t now);
+    bool due(uint64_t now) const { return !q.empty() && q.front().due <= now; }
+    uint64_t nextDue() const { return q.empty() ? NONE : q.front().due; }
+    /**
+     * @brief Retira o próximo pacote a sair; devolva `bytes` com recycle().
+     */
+    Packet pop();
+    void recycle(std::vector<uint8_t>&& b);
+    void clear();
+
+    size_t queued() const { return q.size(); }
+    const Config& config() const { return cfg; }
+    const Counters& counters() const { return stats; }
+
+private:
+    struct Later {
+        bool operator()(const Packet& a, const Packet& b) const { return a > b; }
+    };
+
+    bool lose();
+    void push(Packet&& p);
+    std::vector<uint8_t> buffer();
+    double uniform() { return std::uniform_real_distribution<double>(0, 1)(rng); }
+
+    Config cfg;
+    std::mt19937_64 rng;
+    bool bad = false;      // Estado do Gilbert-Elliott
+    uint64_t linkFree = 0; // µs em que o enlace termina de serializar o último
+    uint64_t order = 0;
+    std::vector<Packet> q; // heap por (due, order)
+    std::vector<std::vector<uint8_t>> spare; // Buffers reaproveitados
+    Counters stats;
+};
+
+/**
+ * @class ImpairedTransport
+ * @brief Transport que aplica um perfil de degradação a outro Transport.
+ *
+ * Como os atrasos são cumpridos dentro de wait(), o decorador serve a
+ * quem usa o laço bloqueante da Network; um EventLoop (epoll em
+ * pollFd()) só veria os datagramas atrasados no próximo evento.
+ */
+class ImpairedTransport : public Transport {
+public:
+    using Link = ImpairedLink::Config;
+    using Counters = ImpairedLink::Counters;
+
+    struct Config {
+        Link tx, rx;
+        uint64_t seed = 1;
+    };
+
+    ImpairedTransport(std::shared_ptr<Transport> inner, const Config& cfg);
+
+    const char* name() const override { return inner->name(); }
+    bool open() override { return inner->open(); }
+    void close() override;
+    bool bind(const sockaddr_in& local) override { return inner->bind(local); }
+    size_t send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) override;
+    bool wait(uint64_t timeoutMs) override;
+    size_t recv(Datagram* out, size_t max) override;
+    bool enableOffload() override { return inner->enableOffload(); }
+    bool offloadActive() const override { return inner->offloadActive(); }
+    int fd() const override { return inner->fd(); }
+    int pollFd() const override { return inner->pollFd(); }
+
+    const Counters& txCounters() const { return tx.counters(); }
+    const Counters& rxCounters() const { return rx.counters(); }
+
+private:
+    void flushTx(uint64_t now);
+    void pullRx(uint64_t now);
+
+    std::shared_ptr<Transport> inner;
+    ImpairedLink tx, rx;
+    std::vector<ImpairedLink::Packet> outbox;    // Saídas do flushTx corrente
+    std::vector<OutDatagram> batch;
+    std::vector<std::vector<uint8_t>> delivered; // Donos dos Datagram do último recv()
+    std::vector<Datagram> inbox;
+};
+
+/**
+ * @brief Lê um perfil como "loss=0.02,burst=3,delay=20,jitter=5,rate=10m,seed=7".
+ *
+ * Chaves: loss, burst, delay e jitter (ms, aceitam fração), reorder, dup,
+ * rate (bits/s, sufixos k/m/g), queue e seed. Sem prefixo valem para as
+ * duas direções; "tx." ou "rx." restringem a uma (ex.: "rx.loss=0.1").
+ * @return false se alguma chave ou valor for inválido.
+ */
+bool parseImpairment(const std::string& spec, ImpairedTransport::Config& out);
+
+#endif
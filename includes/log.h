@@ -0,0 +1,214 @@
+#ifndef LOG_H
+#define LOG_H
+
+/**
+ * @file    log.h
+ * @brief   Log assíncrono com níveis, filtros por categoria e remoção em
+ *          tempo de compilação.
+ *
+ * No caminho quente só se monta um registro binário (campos do
+ * cabeçalho, formato literal e argumentos crus) numa fila circular sem
+ * locks; uma thread de fundo formata os registros e os entrega aos
+ * sinks. Se a fila encher o registro é descartado e contado: quem loga
+ * nunca espera pelo terminal ou pelo arquivo.
+ *
+ * Use sempre as macros: com `-DSLOW_LOG_MIN_LEVEL=SLOW_LOG_WARN` (ou
+ * `make LOG=WARN`) as chamadas abaixo do nível somem do binário.
+ */
+
+#include "packet.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#define SLOW_LOG_TRACE 0
+#define SLOW_LOG_DEBUG 1
+#define SLOW_LOG_INFO  2
+#define SLOW_LOG_WARN  3
+#define SLOW_LOG_ERROR 4
+#define SLOW_LOG_OFF   5
+
+#ifndef SLOW_LOG_MIN_LEVEL
+#define SLOW_LOG_MIN_LEVEL SLOW_LOG_TRACE
+#endif
+
+namespace slowlog {
+
+enum class Level : uint8_t { Trace, Debug, Info, Warn, Error, Off };
+enum class Cat : uint8_t { Packet, Flow, Retx, Session, Io, App, Count };
+
+const char* levelName(Level l);
+const char* catName(Cat c);
+
+/**
+ * @brief Cabeçalho de um pacote, copiado campo a campo.
+ */
+struct PacketHdr {
+    uint8_t sid[UUID_SIZE];
+    uint32_t sttl, seqnum, acknum;
+    uint16_t window;
+    uint8_t flags, fid, fo;
+    uint16_t dataLen;
+};
+
+/**
+ * @brief Registro binário da fila; só a thread de fundo o formata.
+ *
+ * `fmt` é sempre um literal: para texto, o formato com `{}` no lugar de
+ * cada argumento; para pacotes, o rótulo ("TX", "RX"). Strings passadas
+ * como argumento são copiadas para `text`, assim como o início do
+ * payload de um pacote.
+ */
+struct Record {
+    static constexpr size_t MAX_ARGS = 4;
+    static constexpr size_t TEXT_MAX = 64;
+    enum ArgType : uint8_t { Int, Uint, Dbl, Str };
+
+    uint64_t ns;     // Relógio monotônico
+    const char* fmt;
+    Level level;
+    Cat cat;
+    bool packet;
+    uint8_t nargs;
+    uint8_t types[MAX_ARGS];
+    union {
+        union { int64_t i; uint64_t u; double d; } args[MAX_ARGS];
+        PacketHdr hdr;
+    };
+    uint8_t textLen;
+    char text[TEXT_MAX];
+};
+
+/**
+ * @brief Destino dos registros formatados; chamado só pela thread de fundo.
+ */
+class Sink {
+public:
+    virtual ~Sink() = default;
+    virtual void write(const Record& r) = 0;
+    virtual void flush() {}
+};
+
+/**
+ * @brief Formato histórico do cliente: pacotes em "caixa" e trecho do
+ *        payload; texto numa linha. Warn/Error vão para `err`.
+ */
+std::unique_ptr<Sink> makeBoxSink(std::ostream& out, std::ostream& err);
+/**
+ * @brief Uma linha por registro com tempo, nível e categoria (ex.: arquivo).
+ */
+std::unique_ptr<Sink> makeLineSink(FILE* out);
+
+/**
+ * @brief Troca os sinks (o padrão é um box sink em cout/cerr).
+ */
+void setSink(std::unique_ptr<Sink> s);
+void addSink(std::unique_ptr<Sink> s);
+
+/**
+ * @brief Nível mínimo de todas as categorias.
+ */
+void setLevel(Level l);
+void setLevel(Cat c, Level l);
+/**
+ * @brief Aplica uma especificação como "info,packet=off,retx=debug".
+ * @return false se algum nome for desconhecido.
+ */
+bool configure(const std::string& spec);
+
+/**
+ * @brief Espera a thread de fundo escrever tudo o que já foi enfileirado.
+ */
+void flush();
+/**
+ * @brief Registros perdidos por fila cheia.
+ */
+uint64_t dropped();
+
+bool enabled(Level l, Cat c);
+
+/**
+ * @brief Nível presente no binário (SLOW_LOG_MIN_LEVEL).
+ */
+constexpr Level MIN_LEVEL = Level(SLOW_LOG_MIN_LEVEL);
+constexpr bool compiledIn(Level l) { return l >= MIN_LEVEL; }
+
+/* ───────── caminho quente (use as macros) ───────── */
+namespace detail {
+
+Record* claim(size_t& pos);
+void publish(size_t pos);
+uint64_t now();
+
+inline void put(Record& r, size_t i, const char* s) {
+    r.types[i] = Record::Str;
+    if (r.textLen >= Record::TEXT_MAX) { r.args[i].u = Record::TEXT_MAX - 1; return; } // '\0' final
+    size_t n = s ? std::char_traits<char>::length(s) : 0;
+    n = std::min<size_t>(n, Record::TEXT_MAX - r.textLen - 1);
+    r.args[i].u = r.textLen;
+    std::char_traits<char>::copy(r.text + r.textLen, s, n);
+    r.text[r.textLen + n] = '\0';
+    r.textLen = uint8_t(r.textLen + n + 1);
+}
+inline void put(Record& r, size_t i, const std::string& s) { put(r, i, s.c_str()); }
+template <typename T>
+inline std::enable_if_t<std::is_arithmetic_v<T>> put(Record& r, size_t i, T v) {
+    if constexpr (std::is_floating_point_v<T>) { r.types[i] = Record::Dbl; r.args[i].d = double(v); }
+    else if constexpr (std::is_signed_v<T>) { r.types[i] = Record::Int; r.args[i].i = int64_t(v); }
+    else { r.types[i] = Record::Uint; r.args[i].u = uint64_t(v); }
+}
+
+} // namespace detail
+
+template <typename... A>
+void write(Level l, Cat c, const char* fmt, const A&... a) {
+    static_assert(sizeof...(A) <= Record::MAX_ARGS, "argumentos demais para um registro");
+    size_t pos;
+    Record* r = detail::claim(pos);
+    if (!r) return;
+    r->ns = detail::now();
+    r->fmt = fmt;
+    r->level = l;
+    r->cat = c;
+    r->packet = false;
+    r->nargs = uint8_t(sizeof...(A));
+    r->textLen = 0;
+    size_t i = 0;
+    (detail::put(*r, i++, a), ...);
+    detail::publish(pos);
+}
+
+void packet(Level l, const char* tag, const SlowPacketView& p);
+
+} // namespace slowlog
+
+#if SLOW_LOG_MIN_LEVEL >= SLOW_LOG_OFF
+#define SLOW_LOG(lvl, cat, ...) ((void)0)
+#define SLOW_LOG_PACKET(lvl, tag, pkt) ((void)0)
+#else
+/**
+ * @brief SLOW_LOG(Info, Retx, "seq {} (try {})", seq, tries)
+ */
+#define SLOW_LOG(lvl, cat, ...)                                                              \
+    do {                                                                                     \
+        if constexpr (::slowlog::compiledIn(::slowlog::Level::lvl))                          \
+            if (::slowlog::enabled(::slowlog::Level::lvl, ::slowlog::Cat::cat))              \
+                ::slowlog::write(::slowlog::Level::lvl, ::slowlog::Cat::cat, __VA_ARGS__);   \
+    } while (0)
+/**
+ * @brief SLOW_LOG_PACKET(Debug, "TX", view): cabeçalho + início do payload.
+ */
+#define SLOW_LOG_PACKET(lvl, tag, pkt)                                                       \
+    do {                                                                                     \
+        if constexpr (::slowlog::compiledIn(::slowlog::Level::lvl))                          \
+            if (::slowlog::enabled(::slowlog::Level::lvl, ::slowlog::Cat::Packet))           \
+                ::slowlog::packet(::slowlog::Level::lvl, tag, pkt);                          \
+    } while (0)
+#endif
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/**
+ * @file    metrics.h
+ * @brief   Registro de métricas (contadores, gauges e histograma de RTT)
+ *          sem locks, exportado no formato texto do Prometheus.
+ *
+ * Cada thread escreve só no seu shard: no caminho quente uma métrica é
+ * um load e um store relaxados na própria linha de cache, sem operação
+ * atômica de leitura-modificação-escrita nem disputa entre threads. A
+ * leitura (snapshot) soma todos os shards; os shards nunca são
+ * liberados, então os totais de threads já encerradas continuam valendo.
+ *
+ * Os gauges também são somas: cada dono publica só a variação do seu
+ * valor (ver Network::publishGauges), e o total é o agregado do processo.
+ */
+
+#include "histogram.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace metrics {
+
+enum class Counter : uint8_t {
+    TxPackets, TxBytes, RxPackets, RxBytes,
+    Retransmits, FastRetransmits, Drops,  // Drops: pendentes descartados após MAX_TRIES
+    WindowStalls, BufferStalls,           // [FLOW]: janela cheia / pool sem slot
+    Handshakes, Revives, KeepAlives,
+    WindowProbes, PiggybackedAcks,        // Probes de janela zero / ACKs levados por dados
+    Count
+};
+enum class Gauge : uint8_t { BytesInFlight, PendingPackets, Cwnd, Count };
+
+constexpr size_t COUNTERS = size_t(Counter::Count);
+constexpr size_t GAUGES = size_t(Gauge::Count);
+
+/**
+ * @brief Métricas de uma thread; só ela escreve.
+ */
+struct Shard {
+    std::array<std::atomic<uint64_t>, COUNTERS> counters{};
+    std::array<std::atomic<int64_t>, GAUGES> gauges{};
+    std::array<std::atomic<uint64_t>, Histogram::BUCKETS> rtt{}; // Amostras de RTT (ms)
+    std::atomic<uint64_t> rttSum{0};
+    Shard* next = nullptr;
+};
+
+/**
+ * @brief Soma de todos os shards num instante.
+ */
+struct Snapshot {
+    static constexpr double RTT_LE[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1,
+                                        0.25, 0.5, 1, 2.5, 5, 10}; // s, faixas do Prometheus
+    static constexpr size_t RTT_BUCKETS = sizeof RTT_LE / sizeof RTT_LE[0];
+
+    uint64_t ms = 0; // nowMs() da coleta
+    std::array<uint64_t, COUNTERS> counters{};
+    std::array<int64_t, GAUGES> gauges{};
+    Histogram rtt; // ms, para percentis
+    std::array<uint64_t, RTT_BUCKETS> rttLe{}; // Acumulado por faixa RTT_LE
+    uint64_t rttSumMs = 0;
+    uint64_t logDropped = 0;
+
+    uint64_t operator[](Counter c) const { return counters[size_t(c)]; }
+    int64_t operator[](Gauge g) const { return gauges[size_t(g)]; }
+};
+
+const char* name(Counter c);
+const char* name(Gauge g);
+
+Snapshot snapshot();
+/**
+ * @brief Texto no formato de exposição do Prometheus (versão 0.0.4).
+ */
+std::string render(const Snapshot& s);
+
+/* ───────── caminho quente ───────── */
+namespace detail {
+
+Shard* attach(); // Registra o shard da thread na lista global
+
+inline Shard& local() {
+    thread_local Shard* s = attach();
+    return *s;
+}
+
+template <typename T>
+inline void bump(std::atomic<T>& v, T n) {
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+inline void add(Counter c, uint64_t n = 1) { detail::bump(detail::local().counters[size_t(c)], n); }
+inline void add(Gauge g, int64_t delta) {
+    if (delta) detail::bump(detail::local().gauges[size_t(g)], delta);
+}
+inline void observeRtt(uint64_t ms) {
+    Shard& s = detail::local();
+    detail::bump(s.rtt[Histogram::bucketOf(ms)], uint64_t(1));
+    detail::bump(s.rttSum, ms);
+}
+
+/**
+ * @class Exporter
+ * @brief Publica snapshots numa thread de fundo: num arquivo reescrito
+ *        a cada período (troca atômica, p/ o textfile collector) e/ou
+ *        num socket unix local que responde a cada conexão.
+ */
+class Exporter {
+public:
+    struct Config {
+        std::string file;   // Vazio = sem arquivo
+        std::string socket; // Vazio = sem socket
+        uint64_t periodMs = 1000;
+    };
+
+    Exporter() = default;
+    ~Exporter() { stop(); }
+    Exporter(const Exporter&) = delete;
+    Exporter& operator=(const Exporter&) = delete;
+
+    bool start(const Config& c);
+    void stop();
+
+private:
+    void run();
+    bool writeFile(const std::string& text);
+    void serveOne();
+
+    Config cfg;
+    int lfd = -1;
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+} // namespace metrics
+
+#endif
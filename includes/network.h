@@ -12,61 +12,254 @@
  */
 
 #include "packet.h"
+#include "capture.h"
+#include "flow_control.h"
+#include "impairment.h"
+#include "metrics.h"
 #include "session.h"
+#include "session_cache.h"
+#include "congestion.h"
+#include "timer_wheel.h"
+#include "transport.h"
+#include "packet_pool.h"
+#include "reassembler.h"
+#include "ring.h"
 #include <array>
-#include <deque>
+#include <memory>
+#include <string>
 #include <cstring>
+#include <algorithm>
 #include <chrono>
+#include <vector>
 #include <netinet/in.h>
 
+/**
+ * @brief Relógio substituto (ms) para simulação com tempo virtual.
+ *
+ * Nulo no uso normal; o Simulator o instala enquanto existir.
+ */
+extern uint64_t (*nowMsHook)();
+
 /**
  * @brief Retorna timestamp atual em milissegundos.
  */
 static inline uint64_t nowMs() {
     using namespace std::chrono;
+    if (nowMsHook) return nowMsHook();
     return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
+/**
+ * @brief Estimativas de RTT mantidas pela camada de rede (ms).
+ *
+ * `valid` só fica verdadeiro após a primeira amostra; até lá o RTO
+ * é o valor inicial conservador. Um timeout dobra `rto`, que segue
+ * dobrado até a próxima amostra válida (RFC 6298 §5.5 e §5.7).
+ */
+struct RttStats {
+    double srtt = 0;
+    double rttvar = 0;
+    uint64_t rto = 0;
+    uint64_t samples = 0;
+    bool valid = false;
+};
+
 /**
  * @class Network
  * @brief Interface de envio e recepção para o protocolo SLOW.
  *
- * Gerencia socket UDP, controle de fluxo, envio com retransmissão
- * confiável, e integração com a estrutura de sessão.
+ * Gerencia controle de fluxo, envio com retransmissão confiável e
+ * integração com a estrutura de sessão; o socket UDP em si fica a
+ * cargo de um backend Transport.
  */
 class Network {
 public:
+    static constexpr size_t MAX_BATCH = 64; // Datagramas por sendmmsg/recvmmsg
+
     Network(); ~Network();
      /**
-     * @brief Cria o socket UDP.
+     * @brief Cria o socket UDP no backend de E/S escolhido.
+     * @param backend Nome do backend ("socket" ou, se compilado, "uring").
      * @return true se o socket foi criado com sucesso.
      */
-    bool createSocket();
+    bool createSocket(const std::string& backend = "socket");
+    /**
+     * @brief Passa a usar um backend já aberto e compartilhado.
+     *
+     * Permite que várias sessões (cada uma com seu Network) dividam um
+     * único socket; closeSocket não fecha um backend compartilhado.
+     */
+    void attach(std::shared_ptr<Transport> t);
+    /**
+     * @brief Passa o backend atual por um ImpairedTransport (perda,
+     *        atraso, reordenação...); chamar depois de createSocket/attach.
+     */
+    void impair(const ImpairedTransport::Config& cfg);
     /**
      * @brief Envia um pacote via UDP.
      *
      * Se houver payload, o pacote é colocado na fila de retransmissão.
-     * Respeita a janela de envio da sessão remota.
+     * Respeita a janela de envio da sessão remota. O cabeçalho e o
+     * payload saem em iovecs separados; o payload só é copiado uma vez,
+     * para o buffer de retransmissão.
      *
      * @param addr     Destino.
-     * @param pkt      Pacote SLOW.
+     * @param pkt      Pacote SLOW (um SlowPacket converte implicitamente).
      * @param lastSeq  Último seqnum transmitido (retorno).
      * @param sess     Sessão associada.
      * @return true se o envio foi realizado.
      */
-    bool sendPacket(const sockaddr_in& addr, const SlowPacket& pkt, uint32_t& lastSeq, Session& sess);
+    bool sendPacket(const sockaddr_in& addr, const SlowPacketView& pkt, uint32_t& lastSeq, Session& sess);
     /**
      * @brief Tenta receber um pacote do socket.
      *
-     * Se não houver dados após o timeout, chama retransmissão.
-     * Atualiza o estado da sessão com base no pacote recebido.
+     * Aguarda até RECV_WAIT_MS, acordando a cada deadline de
+     * retransmissão para reenviar os pacotes vencidos. Atualiza o
+     * estado da sessão com base no pacote recebido.
      *
-     * @param pkt   Pacote recebido.
+     * @param pkt   Pacote recebido (cópia proprietária).
      * @param from  Endereço de origem.
      * @param sess  Sessão a ser atualizada.
      * @return true se algo foi recebido com sucesso.
      */
     bool receivePacket(SlowPacket& pkt, sockaddr_in& from, Session& sess);
+    /**
+     * @brief Envia um lote de pacotes com uma única syscall (sendmmsg).
+     *
+     * O lote é cortado no primeiro pacote que não couber na janela
+     * efetiva; os enviados entram na fila de retransmissão como em
+     * sendPacket.
+     *
+     * @param addr  Destino.
+     * @param pkts  Pacotes a enviar, em ordem de seqnum; o payload de
+     *              cada um sai direto do buffer para o qual aponta.
+     * @param n     Quantidade (no máximo MAX_BATCH).
+     * @param sess  Sessão associada.
+     * @return quantos pacotes (prefixo de `pkts`) foram enviados.
+     */
+    size_t sendBatch(const sockaddr_in& addr, const SlowPacketView* pkts, size_t n, Session& sess);
+    /**
+     * @brief Recebe todos os datagramas já enfileirados (recvmmsg).
+     *
+     * Bloqueia como receivePacket até o primeiro chegar e drena o
+     * restante sem esperar. Não há cópia: as views apontam para os
+     * buffers do backend e valem até a próxima recepção.
+     *
+     * @param out   Destino dos pacotes decodificados.
+     * @param max   Capacidade de `out`.
+     * @param from  Origem do último pacote recebido.
+     * @param sess  Sessão a ser atualizada.
+     * @return quantidade de pacotes válidos em `out`.
+     */
+    size_t receiveBatch(SlowPacketView* out, size_t max, sockaddr_in& from, Session& sess);
+    /**
+     * @brief Aplica um datagrama lido por outra pessoa (ex.: EventLoop).
+     *
+     * Versão não bloqueante de receivePacket: decodifica, processa ACKs
+     * e atualiza a sessão, sem tocar no socket.
+     *
+     * @return true se o datagrama era um pacote SLOW válido.
+     */
+    bool onDatagram(const Datagram& dg, SlowPacketView& pkt, Session& sess);
+    /**
+     * @brief Sem esperar pelo socket: reenvia os pendentes vencidos,
+     *        sonda a janela zero e envia o ACK atrasado, se vencidos.
+     * @return quantidade de pacotes retransmitidos.
+     */
+    int onTimer(Session& sess) { return service(sess); }
+    /**
+     * @brief Próximo deadline (retransmissão, probe ou ACK atrasado), ou
+     *        TimerWheel::NONE.
+     */
+    uint64_t nextDeadline() const { return std::min(timers.nextDeadline(), flow.nextDeadline()); }
+    /**
+     * @brief Janela do peer menor que `need` bytes e nada em voo: arma o
+     *        persist timer, que sonda `to` com backoff até ela comportar
+     *        o próximo fragmento.
+     */
+    void windowClosed(const sockaddr_in& to, uint32_t need);
+    /**
+     * @brief Deixa o ACK do último pacote recebido para o próximo envio
+     *        com dados (carona) ou para daqui a ACK_DELAY_MS (ex.: o ACK
+     *        do handshake).
+     */
+    void deferAck(const sockaddr_in& to);
+    /**
+     * @brief Envia já, como pure-ACK, o ACK pendente (se houver).
+     */
+    void flushAck(Session& sess);
+    /**
+     * @brief Passa os dados recebidos por um Reassembler (não proprietário).
+     *
+     * Com ele ligado, cada lote recebido com dados é respondido com um
+     * pure-ACK cumulativo, e `recvWindow` acompanha o espaço livre.
+     */
+    void setReassembler(Reassembler* r) { rx = r; }
+    /**
+     * @brief Grava todo datagrama enviado (inclusive retransmissões) e
+     *        recebido numa captura (não proprietária); nullptr desliga.
+     */
+    void setCapture(Capture* c) { cap = c; }
+    /**
+     * @brief Mantém `c` com o estado da sessão a cada envio e recepção
+     *        (não proprietário); nullptr desliga.
+     */
+    void setSessionCache(SessionCache* c) { cache = c; }
+    /**
+     * @brief Liga o modo de offload UDP_SEGMENT (GSO) / UDP_GRO no Linux.
+     *
+     * Com GSO, os pacotes de um lote de mesmo tamanho seguem num único
+     * sendmsg e o kernel os segmenta; com GRO, datagramas coalescidos
+     * pelo kernel são divididos no backend. Se o socket não suportar as
+     * opções (ou o envio falhar depois), o caminho normal continua sendo
+     * usado. Só o backend "socket" implementa offload.
+     *
+     * @return true se ao menos GSO ficou ativo.
+     */
+    bool enableOffload();
+    bool offloadActive() const;
+    /**
+     * @brief Nome do backend de E/S em uso.
+     */
+    const char* backend() const { return io ? io->name() : "-"; }
+    /**
+     * @brief Quantidade de pacotes aguardando ACK.
+     */
+    size_t pendingCount() const { return pend.size(); }
+    /**
+     * @brief Bytes de dados descartados após MAX_TRIES desde a criação;
+     *        quem envia compara com o valor do início para saber se algo
+     *        se perdeu de vez.
+     */
+    uint64_t droppedBytes() const { return dropped; }
+    /**
+     * @brief ms do último datagrama válido recebido (0 = nenhum); base
+     *        do STTL que o peer está contando para a sessão.
+     */
+    uint64_t lastHeard() const { return heard; }
+    /**
+     * @brief SRTT, RTTVAR e RTO correntes.
+     */
+    const RttStats& rttStats() const { return rtt; }
+    /**
+     * @brief Janela efetiva de envio: min(cwnd, remoteWindow).
+     */
+    uint32_t sendWindow(const Session& sess) const { return std::min(cc->cwnd(), sess.remoteWindow); }
+    /**
+     * @brief Troca o algoritmo de controle de congestionamento.
+     *
+     * O novo controlador começa do zero (slow start); o que está em
+     * voo continua sendo contabilizado normalmente.
+     */
+    void setCongestionControl(std::unique_ptr<CongestionController> c) { if (c) cc = std::move(c); }
+    const CongestionController& congestion() const { return *cc; }
+    /**
+     * @brief Descarta todos os pendentes e zera `bytesInFlight`.
+     *
+     * Usado quando a sessão é encerrada ou revivida e o que estava
+     * em voo deixa de fazer sentido.
+     */
+    void resetFlight(Session& sess);
     void closeSocket();
 
 private:
@@ -74,26 +267,67 @@ private:
      * @brief Representa um pacote aguardando ACK.
      */
     struct Pending {
-        std::array<uint8_t, MAX_PACKET> buf;
-        size_t len;
-        uint32_t seq;
-        size_t dataSz;
-        uint64_t sentAt;
-        int tries;
-        Pending(const uint8_t* b, size_t l, uint32_t s, size_t d)
-        : len(l), seq(s), dataSz(d), sentAt(nowMs()), tries(0) {
-            std::memcpy(buf.data(), b, l);
-        }
+        PacketRef buf; // Datagrama completo, escrito uma vez no pool
+        size_t len = 0;
+        uint32_t seq = 0;
+        size_t dataSz = 0;
+        uint64_t sentAt = 0;
+        uint64_t deadline = 0;
+        int tries = 0;
+        bool sacked = false; // peer indicou que já tem este seq (scoreboard)
+        bool fastRetx = false; // já reenviado na recuperação corrente
+        Pending() = default;
+        Pending(PacketRef b, size_t l, uint32_t s, size_t d, uint64_t dl)
+        : buf(std::move(b)), len(l), seq(s), dataSz(d), sentAt(nowMs()), deadline(dl) {}
     };
 
-    static constexpr uint64_t RETRY_MS = 500; // Timeout de retransmissão (ms)
+    static constexpr uint64_t INITIAL_RTO_MS = 500; // RTO antes da primeira amostra (ms)
+    static constexpr uint64_t MIN_RTO_MS = 50; // Piso do RTO (ms)
+    static constexpr uint64_t MAX_RTO_MS = 8000; // Teto do RTO, inclusive com backoff (ms)
     static constexpr int MAX_TRIES = 5; // Máximo de tentativas por pacote
+    static constexpr uint64_t RECV_WAIT_MS = 500; // Espera máxima de receivePacket (ms)
+    static constexpr int DUPACK_THRESHOLD = 3; // ACKs duplicados que disparam fast retransmit
 
-    std::deque<Pending> pend; // Fila de pacotes aguardando ACK
-    void pushPending(const uint8_t* buf, size_t len, uint32_t seq, size_t dsz);
+    std::unique_ptr<PacketPool> pool; // Buffers dos pendentes (criado no primeiro envio)
+    Ring<Pending> pend; // Fila de pacotes aguardando ACK (ordenada por seq)
+    TimerWheel timers; // Deadline de retransmissão de cada pendente
+    std::vector<uint32_t> expired; // Buffer reutilizado por retransmit
+    sockaddr_in peer{}; // Destino dos pacotes pendentes
+    RttStats rtt; // SRTT/RTTVAR/RTO estilo RFC 6298
+    uint32_t lastAck = 0; // Último acknum cumulativo visto
+    uint64_t heard = 0; // ms do último datagrama válido recebido
+    uint64_t dropped = 0; // Bytes descartados após MAX_TRIES (ver droppedBytes)
+    int backedOff = 0; // Maior tentativa que já dobrou o RTO no episódio atual (0 = nenhuma)
+    int dupAcks = 0; // ACKs duplicados consecutivos para lastAck
+    bool inRecovery = false; // Em recuperação rápida (NewReno)
+    uint32_t recover = 0; // Maior seq em voo ao entrar em recuperação
+    std::unique_ptr<CongestionController> cc; // Controle de congestionamento ativo
+    std::array<int64_t, metrics::GAUGES> shown{}; // Parcela já publicada nos gauges
+    FlowControl flow; // Persist timer e ACK pendente
+    sockaddr_in probeTo{}; // Destino dos probes de janela zero
+    void publishGauges(const Session& sess);
+    void sampleRtt(uint64_t ms);
+    void backoff();
+    void pushPending(PacketRef buf, ByteSpan payload, uint32_t seq);
     void dropAcked(uint32_t ack, Session& sess);
-    bool retransmit(const sockaddr_in& addr, Session& sess);
-    int sockfd = -1;
+    int retransmit(Session& sess);
+    int service(Session& sess);
+    void sendPureAck(const sockaddr_in& to, Session& sess);
+    void onAck(const SlowPacketView& pkt, Session& sess);
+    void resend(Pending& p, uint64_t now, uint64_t timeout);
+    void fastRetransmit(Pending& p);
+    std::array<std::array<uint8_t, HDR_SIZE>, MAX_BATCH> txHdrs; // Cabeçalhos de pure-ACKs em sendBatch
+    void ensurePool();
+    static bool retained(const SlowPacketView& pkt);
+    void commitSent(const sockaddr_in& addr, const SlowPacketView& pkt, PacketRef buf, Session& sess);
+    bool waitReadable(Session& sess);
+    bool handleDatagram(const Datagram& dg, SlowPacketView& pkt, Session& sess);
+    Reassembler* rx = nullptr; // Remontagem dos dados do peer (opcional)
+    Capture* cap = nullptr; // Captura de tráfego (opcional)
+    SessionCache* cache = nullptr; // Estado persistido da sessão (opcional)
+    sockaddr_in ackTo{}; // Destino do ACK pendente
+    std::shared_ptr<Transport> io; // Backend de E/S
+    bool ownsIo = true; // false quando o backend veio de attach()
 };
 
 #endif
\ No newline at end of file
@@ -75,64 +75,67 @@ struct SlowPacket {
     void deserialize(const uint8_t* src, size_t len);
 };
 
-void packLE(uint8_t* dst, uint32_t v, int nbytes);
-uint32_t unpackLE(const uint8_t* src, int nbytes);
-
-/* ───────── Utilitários de log ───────── */
-namespace detail {
-
-inline void hLine(const char* left, const char* right, int boxW, const std::string& title = "") {
-    std::cout << left;
-    if (!title.empty()) std::cout << ' ' << title << ' ';
-    int fill = boxW - 2 - (title.empty() ? 0 : int(title.size()) + 2);
-    while (fill-- > 0) std::cout << u8"═";
-    std::cout << right << '\n';
-}
-
-inline void vLine(const std::string& body, int boxW) {
-    std::cout << u8"║ " << body;
-    int pad = boxW - 3 - int(body.size());
-    while (pad-- > 0) std::cout << ' ';
-    std::cout << u8"║\n";
-}
-
-}
-
-inline void logPacket(const SlowPacket& p, const std::string& tag) {
-    std::ios old(nullptr); old.copyfmt(std::cout);
-
-    std::ostringstream oss;
-    oss << "SID  : ";
-    for (uint8_t b : p.sid) oss << std::hex << std::setw(2) << std::setfill('0') << int(b);
-    std::string l_sid = oss.str(); oss.str(""); oss.clear();
-    oss.copyfmt(old);
-
-    oss << "FLG  : " << std::setw(3) << std::left << flagsToString(p.flags) << "  STTL: " << p.sttl;
-    std::string l_flg = oss.str(); oss.str(""); oss.clear();
-
-    oss << "SEQ  : " << p.seqnum << "   ACK : " << p.acknum;
-    std::string l_seq = oss.str(); oss.str(""); oss.clear();
-
-    oss << "WIN  : " << p.window << "   FID/FO: " << int(p.fid) << '/' << int(p.fo);
-    std::string l_win = oss.str();
-
-    int inner = std::max({ int(l_sid.size()), int(l_flg.size()), int(l_seq.size()), int(l_win.size()) }) + 2;
-    int boxW = inner + 2;
-
-    using namespace detail;
-    hLine(u8"╔", u8"╗", boxW, tag);
-    vLine(l_sid, boxW);
-    vLine(l_flg, boxW);
-    vLine(l_seq, boxW);
-    vLine(l_win, boxW);
-    hLine(u8"╚", u8"╝", boxW);
-    std::cout << '\n';
+/**
+ * @struct ByteSpan
+ * @brief   Faixa de bytes não proprietária (o mínimo de um std::span).
+ */
+struct ByteSpan {
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+
+    ByteSpan() = default;
+    ByteSpan(const uint8_t* p, size_t n) : ptr(p), len(n) {}
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + len; }
+    uint8_t operator[](size_t i) const { return ptr[i]; }
+};
 
-    std::cout.copyfmt(old);
-}
+/**
+ * @struct SlowPacketView
+ * @brief   Pacote SLOW sem cópia: cabeçalho decodificado, SID e payload
+ *          apontando para o buffer de origem.
+ *
+ * Na recepção, parse() lê o cabeçalho direto do buffer do backend; no
+ * envio, `sid` e `data` apontam para a sessão e para a mensagem do
+ * usuário. Os campos têm os mesmos nomes de SlowPacket, que converte
+ * implicitamente para uma view. A view só vale enquanto o buffer por
+ * trás dela existir.
+ */
+struct SlowPacketView {
+    ByteSpan sid;
+    uint8_t flags = 0;
+    uint32_t sttl = 0;
+    uint32_t seqnum = 0;
+    uint32_t acknum = 0;
+    uint16_t window = 0;
+    uint8_t fid = 0;
+    uint8_t fo = 0;
+    ByteSpan data;
+
+    SlowPacketView() = default;
+    SlowPacketView(const SlowPacket& p)
+    : sid(p.sid.data(), p.sid.size()), flags(p.flags), sttl(p.sttl), seqnum(p.seqnum), acknum(p.acknum),
+      window(p.window), fid(p.fid), fo(p.fo), data(p.data.data(), p.data.size()) {}
+
+    /**
+     * @brief Decodifica o cabeçalho em `buf` sem copiar o payload.
+     * @return false se `len` for menor que HDR_SIZE.
+     */
+    bool parse(const uint8_t* buf, size_t len);
+    /**
+     * @brief Escreve os HDR_SIZE bytes do cabeçalho em `dst`.
+     */
+    void serializeHeader(uint8_t* dst) const;
+    /**
+     * @brief Cópia proprietária (para quem precisa guardar o pacote).
+     */
+    SlowPacket toPacket() const;
+};
 
-inline void printHeaderMini(const SlowPacket& p, const std::string& lbl) {
-    logPacket(p, lbl);
-}
+void packLE(uint8_t* dst, uint32_t v, int nbytes);
+uint32_t unpackLE(const uint8_t* src, int nbytes);
 
 #endif
\ No newline at end of file
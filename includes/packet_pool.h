@@ -0,0 +1,84 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+/**
+ * @file    packet_pool.h
+ * @brief   Pool de buffers de pacote com contagem de referências.
+ *
+ * Os pacotes à espera de ACK ficam em slots de MAX_PACKET bytes de um
+ * slab reservado uma única vez. Cada pendente guarda um PacketRef: o
+ * datagrama é escrito no slot ao ser enviado e as retransmissões reusam
+ * o mesmo buffer, sem cópias nem alocações.
+ */
+
+#include "slow.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class PacketPool;
+
+/**
+ * @class PacketRef
+ * @brief Referência contada a um slot do pool.
+ *
+ * O slot volta à lista livre quando a última referência é destruída.
+ * O pool precisa viver mais que todas as referências.
+ */
+class PacketRef {
+public:
+    PacketRef() = default;
+    PacketRef(const PacketRef& o);
+    PacketRef(PacketRef&& o) noexcept : pool(o.pool), idx(o.idx) { o.pool = nullptr; }
+    PacketRef& operator=(PacketRef o) noexcept { swap(o); return *this; }
+    ~PacketRef() { reset(); }
+
+    uint8_t* data() const;
+    explicit operator bool() const { return pool != nullptr; }
+    void reset();
+    void swap(PacketRef& o) noexcept { std::swap(pool, o.pool); std::swap(idx, o.idx); }
+
+private:
+    friend class PacketPool;
+    PacketRef(PacketPool* p, uint32_t i) : pool(p), idx(i) {}
+    PacketPool* pool = nullptr;
+    uint32_t idx = 0;
+};
+
+/**
+ * @class PacketPool
+ * @brief Slab de capacidade fixa com lista livre (LIFO, o slot mais
+ *        recente ainda está no cache).
+ */
+class PacketPool {
+public:
+    static constexpr size_t SLOT_SIZE = MAX_PACKET;
+
+    explicit PacketPool(size_t slots);
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    /**
+     * @brief Slots necessários para uma janela cheia de `window` bytes
+     *        em fragmentos de MAX_DATA, mais folga para controle.
+     */
+    static size_t slotsForWindow(uint32_t window);
+
+    /**
+     * @brief Reserva um slot livre.
+     * @return referência vazia se o pool estiver esgotado.
+     */
+    PacketRef acquire();
+
+    size_t capacity() const { return refs.size(); }
+    size_t available() const { return freeList.size(); }
+
+private:
+    friend class PacketRef;
+    std::vector<uint8_t> mem; // capacity * SLOT_SIZE
+    std::vector<uint32_t> refs; // Contagem por slot
+    std::vector<uint32_t> freeList;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef REASSEMBLER_H
+#define REASSEMBLER_H
+
+/**
+ * @file    reassembler.h
+ * @brief   Remontagem de mensagens fragmentadas recebidas do peer.
+ *
+ * Os fragmentos (FID/FO com MOREBITS) podem chegar fora de ordem,
+ * duplicados ou intercalados com outras mensagens. Cada um é guardado
+ * num slot de um buffer pré-alocado, na posição indicada pelo FO, e a
+ * mensagem é entregue uma única vez quando o último buraco é preenchido.
+ * O ACK cumulativo e a janela anunciada saem daqui.
+ */
+
+#include "packet.h"
+#include "session.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class Reassembler
+ * @brief Remonta mensagens por (SID, FID) e mantém o ACK cumulativo por SID.
+ *
+ * Um mesmo Reassembler pode atender várias sessões (ex.: EventLoop): o
+ * espaço livre é compartilhado e vira a janela anunciada de todas.
+ *
+ * Fragmentos já cobertos pelo ACK cumulativo não podem ser descartados,
+ * então o buffer precisa comportar uma mensagem máxima (256 FOs) por
+ * sessão recebendo ao mesmo tempo; os que estão à frente do cumulativo
+ * cedem o lugar a um fragmento anterior quando falta espaço.
+ */
+class Reassembler {
+public:
+    static constexpr size_t DEFAULT_SLOTS = 256; // Fragmentos de MAX_DATA no buffer (uma mensagem máxima)
+    static constexpr uint32_t SEQ_WINDOW = 1024; // Seqnums à frente do cumulativo aceitos
+    static constexpr uint64_t STALE_MS = 10000; // Mensagem incompleta é descartada após isso (sob pressão)
+
+    enum class Result { Delivered, Buffered, Duplicate, NoSpace, Ignored };
+
+    /**
+     * @brief Recebe a mensagem completa: SID da sessão, FID e o payload
+     *        (válido só durante a chamada).
+     */
+    using Handler = std::function<void(ByteSpan sid, uint8_t fid, ByteSpan msg)>;
+
+    /**
+     * @param slots     Capacidade em fragmentos de MAX_DATA.
+     * @param maxWindow Teto da janela anunciada (bytes).
+     */
+    explicit Reassembler(size_t slots = DEFAULT_SLOTS, uint16_t maxWindow = UINT16_MAX);
+
+    void onMessage(Handler h) { deliver = std::move(h); }
+
+    /**
+     * @brief Processa um pacote com dados.
+     *
+     * Atualiza `s.acknum` com o maior seqnum recebido em ordem e
+     * `s.recvWindow` com o espaço livre. Um fragmento sem espaço não é
+     * marcado como recebido: o peer o retransmite depois.
+     */
+    Result push(const SlowPacketView& p, Session& s);
+
+    /**
+     * @brief Espaço livre em bytes, limitado a `maxWindow`.
+     */
+    uint16_t window() const;
+    size_t buffered() const { return (slotCount - freeSlots.size()) * MAX_DATA; }
+
+    /**
+     * @brief Descarta o estado (fluxo e mensagens parciais) de uma sessão.
+     */
+    void forget(const Session& s);
+
+private:
+    using Sid = std::array<uint8_t, UUID_SIZE>;
+    static constexpr uint16_t NO_SLOT = UINT16_MAX;
+
+    struct Key {
+        Sid sid;
+        uint8_t fid;
+        bool operator==(const Key& o) const { return fid == o.fid && sid == o.sid; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const;
+    };
+    struct SidHash {
+        size_t operator()(const Sid& s) const;
+    };
+
+    /**
+     * @brief Mensagem em remontagem: slot e tamanho de cada FO.
+     */
+    struct Assembly {
+        std::array<uint16_t, 256> slot;
+        std::array<uint16_t, 256> len{};
+        std::array<uint32_t, 256> seq{};
+        int lastFo = -1; // FO do fragmento sem MOREBITS, se já chegou
+        size_t have = 0;
+        uint64_t touched = 0;
+        Assembly() { slot.fill(NO_SLOT); }
+    };
+
+    /**
+     * @brief Estado de recepção de uma sessão (seqnums do peer).
+     */
+    struct Flow {
+        uint32_t next = 0; // Próximo seqnum esperado em ordem
+        std::vector<bool> seen = std::vector<bool>(SEQ_WINDOW);
+    };
+
+    Result store(const SlowPacketView& p, const Sid& sid, Flow& f);
+    void complete(const Key& k, Assembly& a);
+    void release(Assembly& a);
+    bool evictStale(uint64_t now);
+    bool evictAhead(const Sid& sid, Flow& f, uint32_t seq);
+
+    size_t slotCount;
+    uint16_t maxWindow;
+    std::vector<uint8_t> arena; // slotCount * MAX_DATA
+    std::vector<uint16_t> freeSlots;
+    std::unordered_map<Key, Assembly, KeyHash> parts;
+    std::unordered_map<Sid, Flow, SidHash> flows;
+    std::vector<uint8_t> out; // Mensagem montada entregue ao Handler
+    Handler deliver;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef RING_H
+#define RING_H
+
+/**
+ * @file    ring.h
+ * @brief   Fila circular de capacidade fixa com acesso aleatório.
+ *
+ * Substitui std::deque na fila de retransmissão: a memória é reservada
+ * uma única vez e push_back/pop_front nunca alocam. Os iteradores são
+ * de acesso aleatório, então lower_bound/find_if funcionam como antes.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Ring
+ * @brief Deque de capacidade fixa sobre um vetor circular.
+ *
+ * push_back com o anel cheio é erro do chamador (full() deve ser
+ * consultado antes); erase no meio desloca os elementos seguintes.
+ */
+template <typename T>
+class Ring {
+    template <bool Const>
+    class Iter {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using Owner = std::conditional_t<Const, const Ring*, Ring*>;
+
+        Iter() = default;
+        Iter(Owner r, size_t i) : r(r), i(i) {}
+        operator Iter<true>() const { return {r, i}; }
+
+        reference operator*() const { return (*r)[i]; }
+        pointer operator->() const { return &(*r)[i]; }
+        reference operator[](difference_type n) const { return (*r)[i + n]; }
+        Iter& operator++() { ++i; return *this; }
+        Iter operator++(int) { Iter t = *this; ++i; return t; }
+        Iter& operator--() { --i; return *this; }
+        Iter operator--(int) { Iter t = *this; --i; return t; }
+        Iter& operator+=(difference_type n) { i += n; return *this; }
+        Iter& operator-=(difference_type n) { i -= n; return *this; }
+        Iter operator+(difference_type n) const { return {r, i + n}; }
+        Iter operator-(difference_type n) const { return {r, i - n}; }
+        friend Iter operator+(difference_type n, const Iter& it) { return it + n; }
+        difference_type operator-(const Iter& o) const { return difference_type(i) - difference_type(o.i); }
+        bool operator==(const Iter& o) const { return i == o.i; }
+        bool operator!=(const Iter& o) const { return i != o.i; }
+        bool operator<(const Iter& o) const { return i < o.i; }
+        bool operator>(const Iter& o) const { return i > o.i; }
+        bool operator<=(const Iter& o) const { return i <= o.i; }
+        bool operator>=(const Iter& o) const { return i >= o.i; }
+        size_t index() const { return i; }
+
+    private:
+        Owner r = nullptr;
+        size_t i = 0; // posição lógica (0 = front)
+    };
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    explicit Ring(size_t capacity = 0) { reserve(capacity); }
+
+    /**
+     * @brief Define a capacidade; só pode ser chamado com o anel vazio.
+     */
+    void reserve(size_t capacity) { clear(); slots.resize(capacity); }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == slots.size(); }
+
+    T& operator[](size_t i) { return slots[(head + i) % slots.size()]; }
+    const T& operator[](size_t i) const { return slots[(head + i) % slots.size()]; }
+    T& front() { return (*this)[0]; }
+    T& back() { return (*this)[count - 1]; }
+
+    template <typename... A>
+    T& emplace_back(A&&... args) {
+        T& slot = slots[(head + count) % slots.size()];
+        slot = T(std::forward<A>(args)...);
+        ++count;
+        return slot;
+    }
+    void pop_front() {
+        front() = T();   // solta recursos (ex.: buffers do pool) já
+        head = (head + 1) % slots.size();
+        --count;
+    }
+    void erase(iterator it) {
+        for (size_t i = it.index(); i + 1 < count; ++i) (*this)[i] = std::move((*this)[i + 1]);
+        back() = T();
+        --count;
+    }
+    void clear() {
+        while (count) pop_front();
+        head = 0;
+    }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, count}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, count}; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+
+private:
+    std::vector<T> slots;
+    size_t head = 0;
+    size_t count = 0;
+};
+
+#endif
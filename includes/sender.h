@@ -0,0 +1,122 @@
+#ifndef SENDER_H
+#define SENDER_H
+
+/**
+ * @file    sender.h
+ * @brief   Motor de envio com janela deslizante para mensagens SLOW.
+ *
+ * Substitui o antigo stop-and-wait do comando `d`: mantém em voo
+ * tantos fragmentos quanto a janela remota permitir e avança à medida
+ * que os ACKs cumulativos chegam (processados em Network::dropAcked).
+ */
+
+#include "network.h"
+#include "session.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * @class Sender
+ * @brief Fragmenta e transmite uma mensagem usando a janela da sessão.
+ *
+ * O tamanho de cada fragmento é fixado no início do envio (segment());
+ * enquanto houver espaço livre em
+ * `min(cwnd, remoteWindow) - bytesInFlight` novos fragmentos são
+ * emitidos sem esperar pelo ACK dos anteriores, em lotes de uma única
+ * syscall (Network::sendBatch). Os fragmentos são views sobre a
+ * mensagem do chamador: nada é copiado nem alocado por fragmento.
+ */
+class Sender {
+public:
+    Sender(Network& net, const sockaddr_in& dst, Session& sess);
+
+    /**
+     * @brief Envia uma mensagem completa, fragmentando se necessário.
+     *
+     * @param data Início do payload.
+     * @param len  Tamanho do payload em bytes.
+     * @return true se todos os fragmentos foram confirmados (false se
+     *         algum foi descartado após MAX_TRIES).
+     */
+    bool send(const uint8_t* data, size_t len);
+
+    /**
+     * @brief Versão não bloqueante: prepara o envio de uma mensagem.
+     *
+     * O buffer precisa continuar válido até emitted(): as retransmissões
+     * saem da cópia guardada pela Network. Os fragmentos só saem nas
+     * chamadas a fill(); os ACKs devem ser repassados a onAck().
+     *
+     * @return false se a mensagem passar de maxMessage() (o FO daria a
+     *         volta); objetos maiores vão por BulkTransfer.
+     */
+    bool begin(const uint8_t* data, size_t len);
+    /**
+     * @brief Emite quantos fragmentos couberem na janela agora.
+     *
+     * Se a janela não comportar o próximo fragmento e nada estiver em
+     * voo, arma o persist timer da Network, que sonda a janela com backoff.
+     *
+     * @return quantidade de fragmentos enviados.
+     */
+    size_t fill();
+    /**
+     * @brief Aplica um pacote recebido durante o envio.
+     */
+    void onAck(const SlowPacketView& a);
+    /**
+     * @brief Todos os fragmentos saíram e nenhum está pendente (confirmados
+     *        ou, se lost(), descartados).
+     */
+    bool done() const { return off == len && !net.pendingCount(); }
+    /**
+     * @brief A Network descartou dados desde begin(): a mensagem não
+     *        chegou inteira ao peer.
+     */
+    bool lost() const { return net.droppedBytes() != dropBase; }
+    /**
+     * @brief Todos os fragmentos já saíram (podem faltar ACKs); a próxima
+     *        mensagem já pode começar.
+     */
+    bool emitted() const { return off == len; }
+    size_t sentBytes() const { return off; }
+    /**
+     * @brief Tamanho dos fragmentos da próxima mensagem: min(MAX_DATA,
+     *        remoteWindow), ou MAX_DATA com a janela fechada (quem espera
+     *        ela abrir é o persist timer, não o fragmento).
+     */
+    size_t segment() const;
+    /**
+     * @brief Maior mensagem que cabe em MAX_FRAGS fragmentos de segment().
+     */
+    size_t maxMessage() const { return MAX_FRAGS * segment(); }
+
+private:
+    /**
+     * @brief Aguarda e drena os pacotes recebidos, aplicando os ACKs.
+     * @return true se algo foi recebido.
+     */
+    bool pump();
+
+    static constexpr int MAX_IDLE = 20; // Recepções vazias seguidas antes de desistir
+
+    Network& net;
+    sockaddr_in dst;
+    Session& sess;
+    std::vector<SlowPacketView> tx; // Lote de fragmentos de uma janela (apontam para a mensagem)
+    std::vector<SlowPacketView> rx; // ACKs drenados por pump
+
+    const uint8_t* data = nullptr; // Mensagem em envio
+    size_t len = 0;
+    size_t off = 0; // Bytes já emitidos
+    uint64_t dropBase = 0; // Network::droppedBytes() em begin()
+    size_t seg = MAX_DATA; // Tamanho fixo dos fragmentos
+    bool willFrag = false;
+    uint8_t fid = 0; // 0 = mensagem sem fragmentos; senão difere da anterior
+    uint8_t fo = 0;
+
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/**
+ * @file    server.h
+ * @brief   Lado servidor do protocolo SLOW, como o cliente o espera.
+ *
+ * Servidor de referência para testes e medições sem o servidor público:
+ * emite SIDs no CONNECT (ACCEPT), confirma dados com ACK cumulativo e
+ * janela, trata disconnect (CONNECT|REVIVE|ACK), revive e expiração por
+ * STTL. Um único socket atende todas as sessões; as respostas de um lote
+ * de recepção saem juntas.
+ */
+
+#include "packet.h"
+#include "timer_wheel.h"
+#include "transport.h"
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * @class SlowServer
+ * @brief Máquina de estados das sessões do servidor sobre um Transport.
+ *
+ * A lógica fica em onDatagram() e onTimer(), que recebem o tempo
+ * corrente; runOnce() só espera no backend, drena um lote e envia as
+ * respostas. O servidor não envia dados, então nada é retransmitido do
+ * lado dele: um CONNECT repetido gera outra sessão, que expira sozinha.
+ *
+ * Convenções do servidor público reproduzidas aqui:
+ *  • o ACK de um dado ecoa o seqnum recebido e leva o cumulativo em
+ *    `acknum` (o cliente usa o eco como indicação seletiva);
+ *  • o primeiro dado após o handshake é o seqnum do SETUP + 2, e após
+ *    um revive é o seqnum do REVIVE + 1;
+ *  • o ACK do disconnect tem seqnum e acknum zerados.
+ */
+class SlowServer {
+public:
+    struct Config {
+        uint16_t window = UINT16_MAX; // Janela anunciada sem nada fora de ordem (B)
+        uint32_t sttlMs = 60000;      // STTL anunciado: ms de inatividade até expirar
+        uint64_t seed = 0;            // SIDs e seqnums iniciais (0 = aleatório)
+    };
+
+    struct Counters {
+        uint64_t rxPackets = 0, txPackets = 0;
+        uint64_t dataBytes = 0;   // Payload novo aceito
+        uint64_t messages = 0;    // Mensagens completas (último fragmento em ordem)
+        uint64_t duplicates = 0;
+        uint64_t unknown = 0;     // SID desconhecido ou sessão fechada
+        uint64_t accepted = 0, revived = 0, closed = 0, expired = 0;
+    };
+
+    static constexpr uint32_t SEQ_WINDOW = 1024; // Seqnums à frente do cumulativo aceitos
+
+    SlowServer(std::shared_ptr<Transport> io, const Config& cfg);
+    SlowServer(std::shared_ptr<Transport> io) : SlowServer(std::move(io), Config{}) {}
+
+    /**
+     * @brief Trata um datagrama; a resposta vai para a fila de saída.
+     */
+    void onDatagram(const Datagram& dg, uint64_t now);
+    /**
+     * @brief Expira sessões inativas e esquece as fechadas há mais de um STTL.
+     */
+    void onTimer(uint64_t now);
+    /**
+     * @brief Envia as respostas enfileiradas (um send por destino contíguo).
+     */
+    void flush();
+    /**
+     * @brief Espera até `timeoutMs` (limitado ao próximo deadline),
+     *        processa um lote e responde.
+     * @return datagramas processados.
+     */
+    size_t runOnce(uint64_t timeoutMs);
+
+    uint64_t nextDeadline() const { return timers.nextDeadline(); }
+    size_t sessions() const { return byId.size(); }
+    size_t openSessions() const { return open; }
+    const Counters& counters() const { return stats; }
+
+private:
+    using Sid = std::array<uint8_t, UUID_SIZE>;
+    struct SidHash {
+        size_t operator()(const Sid& s) const;
+    };
+
+    /**
+     * @brief Estado de uma sessão do ponto de vista do servidor.
+     */
+    struct Peer {
+        Sid sid{};
+        sockaddr_in addr{};
+        uint32_t seq = 0;      // seqnum do SETUP (o servidor não envia dados)
+        uint32_t next = 0;     // Próximo seqnum esperado do cliente
+        std::bitset<SEQ_WINDOW> seen; // Recebidos à frente de `next`
+        std::bitset<SEQ_WINDOW> last; // ... e quais fecham uma mensagem
+        uint32_t ahead = 0;    // Quantos estão em `seen`
+        uint64_t lastSeen = 0; // ms da última atividade
+        bool open = true;
+    };
+
+    static constexpr size_t MAX_BATCH = UdpTransport::BATCH;
+
+    void accept(const SlowPacketView& p, const sockaddr_in& from, uint64_t now);
+    void data(Peer& s, const SlowPacketView& p);
+    void reply(const Peer& s, uint8_t flags, uint32_t seq, uint32_t ack);
+    void setOpen(Peer& s, bool o);
+    uint16_t window(const Peer& s) const;
+
+    std::shared_ptr<Transport> io;
+    Config cfg;
+    Counters stats;
+    std::mt19937_64 rng;
+    uint32_t nextId = 1;
+    size_t open = 0;
+    std::unordered_map<uint32_t, Peer> byId;
+    std::unordered_map<Sid, uint32_t, SidHash> bySid;
+    TimerWheel timers; // Verificação de STTL por id (reagendada sob demanda)
+    std::vector<uint32_t> expired;
+
+    struct Reply {
+        sockaddr_in to;
+        std::array<uint8_t, HDR_SIZE> hdr;
+    };
+    std::vector<Reply> outq;
+    std::vector<Datagram> rx;
+};
+
+#endif
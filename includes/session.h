@@ -38,6 +38,11 @@ struct Session {
 
     Session() noexcept;
     static std::array<uint8_t, 16> generateUUID();
+    /**
+     * @brief Faz generateUUID() desta thread seguir uma semente fixa
+     *        (execuções reproduzíveis, ex.: slow_sim).
+     */
+    static void seedUUID(uint64_t seed);
     static std::array<uint8_t, 16> nilUUID();
 };
 
@@ -0,0 +1,79 @@
+#ifndef SESSION_CACHE_H
+#define SESSION_CACHE_H
+
+/**
+ * @file    session_cache.h
+ * @brief   Estado da sessão persistido num arquivo mapeado em memória,
+ *          para que um processo reiniciado retome a sessão com revive
+ *          em vez de refazer o 3-way handshake.
+ *
+ * O arquivo tem um único registro de tamanho fixo. Cada atualização são
+ * algumas escritas na página mapeada (sem syscall); o kernel leva a
+ * página ao disco sozinho, então o registro sobrevive à morte do
+ * processo, não necessariamente a uma queda da máquina. Um contador de
+ * geração (ímpar durante a escrita) denuncia registros pela metade.
+ * Use um arquivo por processo.
+ */
+
+#include "session.h"
+#include <cstdint>
+#include <netinet/in.h>
+
+/**
+ * @class SessionCache
+ * @brief Guarda sid, seqnum, acknum, STTL e janelas da sessão viva.
+ */
+class SessionCache {
+public:
+    static constexpr uint32_t MAGIC = 0x43574c53; // "SLWC"
+    static constexpr uint16_t VERSION = 1;
+
+    SessionCache() = default;
+    ~SessionCache() { close(); }
+    SessionCache(const SessionCache&) = delete;
+    SessionCache& operator=(const SessionCache&) = delete;
+
+    /**
+     * @brief Abre (ou cria) o arquivo e o mapeia.
+     * @param server Servidor a que as sessões gravadas pertencem.
+     */
+    bool open(const char* path, const sockaddr_in& server);
+    void close();
+    bool isOpen() const { return rec != nullptr; }
+
+    /**
+     * @brief Lê a sessão gravada se for do mesmo servidor, estiver
+     *        inteira e ainda dentro do STTL (contado da última gravação).
+     */
+    bool load(Session& s) const;
+    /**
+     * @brief Grava o estado corrente; sessões sem SID são ignoradas.
+     * @param sentSeq Último seqnum enviado, se já à frente de `s.seqnum`
+     *                (o Sender só avança o seqnum depois do envio).
+     */
+    void save(const Session& s, uint32_t sentSeq = 0);
+    /**
+     * @brief Esquece a sessão gravada (ex.: revive recusado).
+     */
+    void invalidate();
+
+private:
+    struct Record {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t valid;
+        uint32_t gen;          // Ímpar enquanto uma gravação está em curso
+        uint32_t serverIp;     // Ordem de rede, como em sockaddr_in
+        uint16_t serverPort;
+        uint16_t recvWindow;
+        uint8_t sid[16];
+        uint32_t seqnum, acknum, sttl;
+        uint32_t remoteWindow;
+        uint64_t savedAt;      // ms do relógio de parede (vale entre processos)
+    };
+
+    Record* rec = nullptr;
+    sockaddr_in srv{};
+};
+
+#endif
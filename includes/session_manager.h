@@ -14,8 +14,30 @@
 
 #include "network.h"
 #include "session.h"
+#include <string>
+
+/*
+ * Passos dos handshakes como funções puras sobre pacotes: as versões
+ * bloqueantes abaixo e o EventLoop (não bloqueante) usam as mesmas.
+ */
+SlowPacket makeConnect(const Session& s);
+bool applySetup(const SlowPacketView& setup, Session& s);
+SlowPacket makeAck(const Session& s);
+SlowPacket makeRevive(Session& s, const std::string& payload = "revive");
+bool applyRevive(const SlowPacketView& resp, Session& s);
+SlowPacket makeDisconnect(Session& s);
 
 bool doThreeWayHandshake(Network& net, sockaddr_in& srv, Session& s);
 bool tryRevive(Network& net, sockaddr_in& srv, Session& s);
 
+/*
+ * Manutenção pelo STTL (ms). O peer expira a sessão STTL depois do
+ * último pacote nosso que recebeu; Network::lastHeard() é a melhor
+ * estimativa local disso. O keep-alive sai na metade do prazo, sobrando
+ * outra metade para repetições antes de presumir a sessão expirada.
+ */
+uint64_t keepAliveDue(const Network& net, const Session& s); // TimerWheel::NONE sem STTL
+bool presumedExpired(const Network& net, const Session& s, uint64_t now);
+bool keepAlive(Network& net, sockaddr_in& srv, Session& s);
+
 #endif
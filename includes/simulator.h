@@ -0,0 +1,132 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+/**
+ * @file    simulator.h
+ * @brief   Simulação de eventos discretos com relógio virtual.
+ *
+ * Substitui o relógio (nowMsHook) e o socket (SimTransport) da Network
+ * para que o código real de envio, ACK e retransmissão rode contra um
+ * peer em processo através de enlaces simulados (ImpairedLink). O tempo
+ * salta direto para o próximo evento, então horas de tráfego levam
+ * segundos; com a mesma semente o resultado é idêntico.
+ */
+
+#include "impairment.h"
+#include "transport.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <netinet/in.h>
+
+class Simulator;
+
+/**
+ * @class SimTransport
+ * @brief Ponta de um enlace simulado.
+ *
+ * send() põe os datagramas no enlace de saída desta ponta; o Simulator
+ * os move para a caixa de entrada do destino quando vencem. wait() não
+ * bloqueia nem avança o tempo: serve a quem é dirigido por eventos
+ * (EventLoop::poll, SlowServer::runOnce(0)), não aos laços bloqueantes
+ * de receivePacket/Sender::send.
+ */
+class SimTransport : public Transport {
+public:
+    SimTransport(Simulator& sim, const sockaddr_in& addr, const ImpairedLink::Config& out, uint64_t seed);
+
+    const char* name() const override { return "sim"; }
+    bool open() override { return true; }
+    void close() override {}
+    bool bind(const sockaddr_in&) override { return true; }
+    size_t send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) override;
+    bool wait(uint64_t) override { return !inbox.empty(); }
+    size_t recv(Datagram* out, size_t max) override;
+    int fd() const override { return -1; }
+
+    const sockaddr_in& address() const { return addr; }
+    const ImpairedLink& link() const { return out; }
+
+private:
+    friend class Simulator;
+    Simulator& sim;
+    sockaddr_in addr;
+    ImpairedLink out; // Enlace de saída desta ponta
+    std::deque<ImpairedLink::Packet> inbox; // Chegados; `addr` é a origem
+    std::vector<std::vector<uint8_t>> delivered; // Donos dos Datagram do último recv()
+};
+
+/**
+ * @class Simulator
+ * @brief Agenda de eventos: entregas nos enlaces, deadlines dos nós e
+ *        eventos da aplicação, sempre em ordem de tempo.
+ *
+ * Só pode existir um por vez (o relógio é global). Nós são registrados
+ * com addNode(): `deadline` informa quando o nó precisa rodar (ms no
+ * relógio virtual, TimerWheel::NONE se nunca) e `poll` o faz rodar; a
+ * cada instante todos os nós são chamados na ordem de registro.
+ */
+class Simulator {
+public:
+    static constexpr uint64_t NONE = UINT64_MAX;
+    static constexpr uint64_t START_US = 1000000; // Relógio virtual começa em 1 s
+
+    explicit Simulator(uint64_t seed = 1);
+    ~Simulator();
+    Simulator(const Simulator&) = delete;
+    Simulator& operator=(const Simulator&) = delete;
+
+    /**
+     * @brief Cria uma ponta em `addr`; `out` é o perfil do que ela envia.
+     */
+    std::shared_ptr<SimTransport> endpoint(const sockaddr_in& addr, const ImpairedLink::Config& out);
+    void addNode(std::function<uint64_t()> deadline, std::function<void()> poll);
+    /**
+     * @brief Agenda `fn` para o instante `ms` do relógio virtual.
+     */
+    void at(uint64_t ms, std::function<void()> fn);
+    /**
+     * @brief Avança até `ms` (inclusive).
+     * @return false se a agenda esvaziou antes disso.
+     */
+    bool runUntil(uint64_t ms);
+
+    uint64_t nowUs() const { return now; }
+    uint64_t nowMs() const { return now / 1000; }
+    uint64_t events() const { return steps; }
+
+private:
+    struct Timer {
+        uint64_t when; // µs
+        uint64_t order;
+        std::function<void()> fn;
+    };
+    struct Later {
+        bool operator()(const Timer& a, const Timer& b) const {
+            return a.when != b.when ? a.when > b.when : a.order > b.order;
+        }
+    };
+    struct Node {
+        std::function<uint64_t()> deadline;
+        std::function<void()> poll;
+    };
+
+    static uint64_t clock();
+    uint64_t nextEvent() const;
+    void deliver();
+    SimTransport* find(const sockaddr_in& a) const;
+
+    static Simulator* current; // Dono do nowMsHook
+    uint64_t seed;
+    uint64_t now = START_US;
+    uint64_t steps = 0;
+    uint64_t order = 0;
+    std::vector<std::shared_ptr<SimTransport>> eps;
+    std::vector<Node> nodes;
+    std::vector<Timer> timers; // heap por (when, order)
+};
+
+#endif
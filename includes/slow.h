@@ -6,5 +6,6 @@ constexpr int HDR_SIZE   = 32;
 constexpr int MAX_DATA   = 1440;
 constexpr int MAX_PACKET = HDR_SIZE + MAX_DATA;
 constexpr int UUID_SIZE  = 16;
+constexpr int MAX_FRAGS  = 256; // FO tem 8 bits: fragmentos por mensagem
 
 #endif
\ No newline at end of file
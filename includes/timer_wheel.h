@@ -0,0 +1,67 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+/**
+ * @file    timer_wheel.h
+ * @brief   Roda de temporizadores (hashed timing wheel) para retransmissão.
+ *
+ * Cada pacote pendente registra um deadline identificado pelo seu seqnum.
+ * Os deadlines são espalhados em slots de largura fixa, de modo que
+ * agendar e expirar custam O(1) amortizado por tick, mesmo com centenas
+ * de pacotes em voo.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Conjunto de deadlines (ms) indexados por uma chave de 32 bits.
+ *
+ * O cancelamento é preguiçoso: quem consome `expire` deve validar se
+ * a chave ainda é relevante (ex.: o pacote pode já ter sido confirmado).
+ */
+class TimerWheel {
+public:
+    static constexpr uint64_t NONE = UINT64_MAX;
+
+    /**
+     * @param tickMs Largura de cada slot em milissegundos.
+     * @param slots  Número de slots (uma volta = tickMs * slots).
+     */
+    explicit TimerWheel(uint64_t tickMs = 10, size_t slots = 512);
+
+    /**
+     * @brief Agenda `key` para expirar em `deadline` (ms absolutos).
+     */
+    void schedule(uint32_t key, uint64_t deadline);
+    /**
+     * @brief Move para `out` todas as chaves com deadline <= `now`.
+     */
+    void expire(uint64_t now, std::vector<uint32_t>& out);
+    /**
+     * @brief Próximo deadline agendado, ou NONE se a roda estiver vazia.
+     *
+     * O resultado fica em cache até um expire() retirar alguma entrada;
+     * schedule() só o reduz.
+     */
+    uint64_t nextDeadline() const;
+    bool empty() const { return count == 0; }
+    void clear();
+
+private:
+    struct Entry {
+        uint32_t key;
+        uint64_t deadline;
+    };
+
+    std::vector<std::vector<Entry>> wheel;
+    uint64_t tickMs;
+    uint64_t cur = 0;   // último tick processado
+    size_t count = 0;
+    mutable uint64_t earliest = NONE; // Cache de nextDeadline()
+    mutable bool stale = false;       // expire() retirou entradas desde o cálculo
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+/**
+ * @file    transport.h
+ * @brief   Backends de E/S de datagramas usados pela Network.
+ *
+ * A Network cuida de confiabilidade, janelas e retransmissão; o
+ * Transport só move datagramas entre o processo e o kernel. Isso
+ * permite trocar o mecanismo de E/S (select + sendmmsg, io_uring)
+ * sem tocar na lógica do protocolo.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Datagrama recebido. `data` aponta para um buffer interno do
+ *        backend e só é válido até a próxima chamada de recv().
+ */
+struct Datagram {
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    sockaddr_in from{};
+};
+
+/**
+ * @brief Datagrama de saída em scatter-gather: cabeçalho e payload em
+ *        iovecs separados, para que o payload saia direto do buffer do
+ *        chamador. O payload pode ter tamanho zero.
+ */
+struct OutDatagram {
+    iovec iov[2]{};
+    size_t size() const { return iov[0].iov_len + iov[1].iov_len; }
+};
+
+/**
+ * @class Transport
+ * @brief Interface mínima de um backend de E/S UDP.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+    virtual const char* name() const = 0;
+    /**
+     * @brief Cria o socket (e demais recursos do backend).
+     */
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    /**
+     * @brief Fixa o endereço local (lado servidor); chamar logo após open().
+     */
+    virtual bool bind(const sockaddr_in& local);
+    /**
+     * @brief Envia `n` datagramas para `to`, cada um montado pelo kernel
+     *        a partir dos seus dois iovecs (sendmsg com scatter-gather).
+     * @return quantos datagramas (prefixo) saíram.
+     */
+    virtual size_t send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) = 0;
+    /**
+     * @brief Bloqueia até haver datagramas a ler ou `timeoutMs` passar.
+     * @return true se recv() tem algo a entregar.
+     */
+    virtual bool wait(uint64_t timeoutMs) = 0;
+    /**
+     * @brief Entrega sem bloquear até `max` datagramas já recebidos.
+     */
+    virtual size_t recv(Datagram* out, size_t max) = 0;
+    /**
+     * @brief Liga offloads de segmentação (GSO/GRO), se o backend suportar.
+     */
+    virtual bool enableOffload() { return false; }
+    virtual bool offloadActive() const { return false; }
+    /**
+     * @brief Descritor do socket, para quem precisar multiplexá-lo.
+     */
+    virtual int fd() const = 0;
+    /**
+     * @brief Descritor que fica legível quando recv() tem algo a entregar.
+     *
+     * É o que um laço de eventos (epoll) deve observar; no backend de
+     * socket coincide com fd().
+     */
+    virtual int pollFd() const { return fd(); }
+};
+
+/**
+ * @class UdpTransport
+ * @brief Backend padrão: select() para esperar, sendmmsg/recvmmsg em
+ *        lote e, opcionalmente, UDP_SEGMENT/UDP_GRO no Linux.
+ */
+class UdpTransport : public Transport {
+public:
+    static constexpr size_t BATCH = 64;
+
+    UdpTransport();
+    ~UdpTransport() override { close(); }
+    const char* name() const override { return "socket"; }
+    bool open() override;
+    void close() override;
+    size_t send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) override;
+    bool wait(uint64_t timeoutMs) override;
+    size_t recv(Datagram* out, size_t max) override;
+    bool enableOffload() override;
+    bool offloadActive() const override { return gso || gro; }
+    int fd() const override { return sockfd; }
+
+private:
+    static constexpr size_t GSO_MAX_BYTES = 65000; // Payload UDP máximo por envio GSO
+    static constexpr size_t GSO_MAX_SEGS = 64; // Limite de segmentos do kernel
+
+    int sockfd = -1;
+    std::vector<uint8_t> rxBuf; // BATCH slots de MAX_PACKET
+    bool gso = false;
+    bool gro = false;
+    std::vector<uint8_t> groBuf; // Datagrama coalescido corrente (GRO)
+    size_t groLen = 0, groOff = 0, groSeg = 0;
+    sockaddr_in groFrom{};
+    size_t sendOffload(const sockaddr_in& to, const OutDatagram* dgrams, size_t n);
+    size_t recvGro(Datagram* out, size_t max);
+};
+
+/**
+ * @brief Converte "ip" ou "ip:porta" (IPv4) em endereço.
+ * @param port Porta usada quando `s` não traz uma.
+ */
+bool parseAddress(const std::string& s, sockaddr_in& out, uint16_t port);
+
+/**
+ * @brief Nomes de backend disponíveis neste build ("socket", "uring").
+ */
+std::vector<std::string> transportNames();
+
+/**
+ * @brief Cria um backend pelo nome.
+ * @return nullptr se o nome for desconhecido ou não compilado.
+ */
+std::unique_ptr<Transport> makeTransport(const std::string& name);
+
+#endif
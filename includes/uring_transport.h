@@ -0,0 +1,83 @@
+#ifndef URING_TRANSPORT_H
+#define URING_TRANSPORT_H
+
+/**
+ * @file    uring_transport.h
+ * @brief   Backend de E/S baseado em io_uring (Linux ≥ 6.0).
+ *
+ * Só é compilado com `make URING=1`. Usa as syscalls diretamente
+ * (sem liburing): um recvmsg multishot fica sempre postado com buffers
+ * fornecidos (IORING_OP_PROVIDE_BUFFERS), envios de um lote inteiro saem numa
+ * única io_uring_enter e a espera por pacotes é um SQE de timeout.
+ */
+
+#ifdef SLOW_WITH_URING
+
+#include "transport.h"
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+/**
+ * @class UringTransport
+ * @brief Transport com recepção multishot e envio em lote via io_uring.
+ */
+class UringTransport : public Transport {
+public:
+    UringTransport() = default;
+    ~UringTransport() override { close(); }
+    const char* name() const override { return "uring"; }
+    bool open() override;
+    void close() override;
+    size_t send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) override;
+    bool wait(uint64_t timeoutMs) override;
+    size_t recv(Datagram* out, size_t max) override;
+    int fd() const override { return sockfd; }
+    int pollFd() const override { return ringfd; } // legível com CQEs pendentes
+
+private:
+    static constexpr unsigned ENTRIES = 256; // Tamanho do SQ
+    static constexpr unsigned NBUFS = 256; // Buffers fornecidos (potência de 2)
+    static constexpr unsigned BUF_SIZE = 2048; // recvmsg_out + nome + MAX_PACKET
+    static constexpr uint16_t BGID = 1; // Grupo dos buffers fornecidos
+    static constexpr uint64_t TAG_RECV = 1, TAG_SEND = 2, TAG_TIMEOUT = 3, TAG_PROVIDE = 4;
+
+    struct Ready {
+        uint16_t bid;
+        Datagram dg;
+    };
+
+    int sockfd = -1;
+    int ringfd = -1;
+
+    // anel de submissão/conclusão mapeado do kernel
+    void* sqMap = nullptr; size_t sqMapSz = 0;
+    void* cqMap = nullptr; size_t cqMapSz = 0;
+    io_uring_sqe* sqes = nullptr; size_t sqesSz = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned sqEntries = 0;
+    unsigned toSubmit = 0;
+
+    // buffers fornecidos para a recepção multishot
+    uint8_t* bufMem = nullptr;
+    msghdr recvHdr{};
+    bool recvArmed = false;
+
+    std::vector<Ready> ready; // Datagramas recebidos ainda não entregues
+    size_t readyHead = 0;
+    std::vector<uint16_t> lent; // Buffers entregues no último recv()
+    __kernel_timespec ts{};
+    std::vector<msghdr> sendHdrs;
+
+    io_uring_sqe* getSqe();
+    int enter(unsigned minComplete, unsigned flags);
+    void armRecv();
+    bool provide(uint16_t bid, unsigned count);
+    void onRecv(const io_uring_cqe& cqe);
+    size_t reap(unsigned* sends = nullptr, unsigned* sendOk = nullptr);
+};
+
+#endif
+
+#endif
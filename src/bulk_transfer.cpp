@@ -0,0 +1,154 @@
+#include "bulk_transfer.h"
+#include "log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @file    bulk_transfer.cpp
+ * @brief   Implementação do envio de objetos grandes.
+ *
+ * O laço é o mesmo de Sender::send, mas quando a mensagem atual termina
+ * de sair a seguinte é preparada na hora e preenche o resto da janela.
+ */
+
+BulkTransfer::BulkTransfer(Network& n, const sockaddr_in& d, Session& s)
+: net(n), sess(s), tx(n, d, s), rx(Network::MAX_BATCH) {}
+
+void BulkTransfer::onProgress(ProgressFn fn, uint64_t intervalMs) {
+    progressFn = std::move(fn);
+    interval = intervalMs;
+}
+
+bool BulkTransfer::send(const uint8_t* data, size_t len) {
+    src = data;
+    srcLen = len;
+    srcOff = 0;
+    fd = -1;
+    prog = Progress{};
+    prog.total = len;
+    return run();
+}
+
+bool BulkTransfer::send(int in) {
+    fd = in;
+    src = nullptr;
+    prog = Progress{};
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) prog.total = uint64_t(st.st_size);
+    return run();
+}
+
+bool BulkTransfer::sendFile(const char* path) {
+    int in = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        SLOW_LOG(Error, App, "[erro] {}: {}", path, strerror(errno));
+        return false;
+    }
+    struct stat st{};
+    void* map = MAP_FAILED;
+    if (fstat(in, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, in, 0);
+
+    bool ok;
+    if (map == MAP_FAILED) ok = send(in);
+    else {
+        // os fragmentos apontam para as páginas do arquivo; o read-ahead
+        // agressivo e o descarte atrás do cursor ficam com o kernel
+        madvise(map, size_t(st.st_size), MADV_SEQUENTIAL);
+        ok = send(static_cast<const uint8_t*>(map), size_t(st.st_size));
+        munmap(map, size_t(st.st_size));
+    }
+    ::close(in);
+    return ok;
+}
+
+/**
+ * @brief Prepara a próxima mensagem (até Sender::maxMessage() bytes).
+ * @return false no fim da origem ou em erro de leitura.
+ */
+bool BulkTransfer::nextMessage() {
+    size_t max = tx.maxMessage(), n = 0;
+    const uint8_t* p;
+    if (fd < 0) {
+        n = min(max, srcLen - srcOff);
+        p = src + srcOff;
+        srcOff += n;
+    } else {
+        chunk.resize(max);
+        while (n < max) {
+            ssize_t r = ::read(fd, chunk.data() + n, max - n);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) {
+                SLOW_LOG(Error, Io, "[erro] leitura: {}", strerror(errno));
+                readErr = true;
+                return false;
+            }
+            if (r == 0) break;
+            n += size_t(r);
+        }
+        p = chunk.data();
+    }
+    if (!n) return false;
+    base += tx.sentBytes();
+    if (!tx.begin(p, n)) return false;
+    ++prog.messages;
+    return true;
+}
+
+bool BulkTransfer::pump() {
+    sockaddr_in from{};
+    size_t n = net.receiveBatch(rx.data(), rx.size(), from, sess);
+    for (size_t i = 0; i < n; ++i) tx.onAck(rx[i]);
+    return n > 0;
+}
+
+void BulkTransfer::report(bool last) {
+    uint64_t now = nowMs();
+    if (!last && now - lastReport < interval) return;
+    lastReport = now;
+    prog.sent = base + tx.sentBytes();
+    // descartados após MAX_TRIES saíram de bytesInFlight sem ACK
+    uint64_t unacked = sess.bytesInFlight + (net.droppedBytes() - dropBase);
+    prog.acked = prog.sent - min<uint64_t>(prog.sent, unacked);
+    prog.elapsedMs = now - start;
+    if (progressFn) progressFn(prog);
+}
+
+bool BulkTransfer::run() {
+    readErr = false;
+    base = 0;
+    dropBase = net.droppedBytes();
+    tx.begin(nullptr, 0);
+    start = lastReport = nowMs();
+
+    bool more = nextMessage();
+    int idle = 0;
+    while (true) {
+        tx.fill();
+        // a mensagem atual já saiu inteira: a próxima usa o resto da janela
+        while (more && tx.emitted()) {
+            more = nextMessage();
+            if (more) tx.fill();
+        }
+        if (!more && tx.done()) break;
+        report(false);
+        if (pump()) idle = 0;
+        else if (++idle >= MAX_IDLE) {
+            SLOW_LOG(Error, App, "[erro] sem resposta do servidor, envio abortado");
+            return false;
+        }
+    }
+    net.flushAck(sess);
+    report(true);
+    if (net.droppedBytes() != dropBase) {
+        SLOW_LOG(Error, App, "[erro] fragmento descartado sem confirmação");
+        return false;
+    }
+    return !readErr;
+}
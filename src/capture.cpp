@@ -0,0 +1,148 @@
+#include "capture.h"
+#include "log.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @file    capture.cpp
+ * @brief   Gravação e leitura de capturas pcap (ns, USER0).
+ */
+
+namespace {
+
+struct PcapHeader {
+    uint32_t magic;
+    uint16_t major, minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t network;
+};
+
+struct PcapRecord {
+    uint32_t sec, nsec;
+    uint32_t inclLen, origLen;
+};
+
+constexpr uint32_t SNAPLEN = 65535;
+
+uint64_t monoNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool writeAll(int fd, const uint8_t* p, size_t n) {
+    while (n) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= size_t(w);
+    }
+    return true;
+}
+
+uint32_t bswap(uint32_t v) { return __builtin_bswap32(v); }
+
+} // namespace
+
+bool Capture::open(const char* path) {
+    close();
+    fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        SLOW_LOG(Error, Io, "[erro] captura {}: {}", path, strerror(errno));
+        return false;
+    }
+    buf.reserve(BUF_SIZE);
+    count = 0;
+    PcapHeader h{MAGIC_NS, 2, 4, 0, 0, SNAPLEN, LINKTYPE_USER0};
+    append(&h, sizeof h);
+    return true;
+}
+
+void Capture::close() {
+    if (fd < 0) return;
+    flush();
+    ::close(fd);
+    fd = -1;
+}
+
+void Capture::flush() {
+    if (fd < 0 || buf.empty()) return;
+    if (!writeAll(fd, buf.data(), buf.size())) {
+        SLOW_LOG(Error, Io, "[erro] captura: {}, gravação interrompida", strerror(errno));
+        ::close(fd);
+        fd = -1;
+    }
+    buf.clear();
+}
+
+void Capture::append(const void* p, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    buf.insert(buf.end(), b, b + n);
+}
+
+/**
+ * @brief Abre um registro de `len` bytes de datagrama: cabeçalho pcap e
+ *        pseudo-cabeçalho. O buffer vai ao disco antes, se não couber.
+ */
+void Capture::begin(Dir dir, const sockaddr_in& peer, size_t len) {
+    size_t total = sizeof(PcapRecord) + PSEUDO_SIZE + len;
+    if (buf.size() + total > BUF_SIZE) flush();
+    uint64_t ns = monoNs();
+    uint32_t incl = uint32_t(PSEUDO_SIZE + len);
+    PcapRecord r{uint32_t(ns / 1000000000), uint32_t(ns % 1000000000), incl, incl};
+    append(&r, sizeof r);
+    uint8_t pseudo[PSEUDO_SIZE] = {uint8_t(dir), 0};
+    memcpy(pseudo + 2, &peer.sin_port, 2);        // ordem de rede
+    memcpy(pseudo + 4, &peer.sin_addr.s_addr, 4); // ordem de rede
+    append(pseudo, sizeof pseudo);
+    ++count;
+}
+
+void Capture::record(Dir dir, const sockaddr_in& peer, const OutDatagram& d) {
+    if (fd < 0) return;
+    begin(dir, peer, d.size());
+    for (const iovec& v : d.iov)
+        if (v.iov_len) append(v.iov_base, v.iov_len);
+}
+
+void Capture::record(Dir dir, const sockaddr_in& peer, const uint8_t* data, size_t len) {
+    if (fd < 0) return;
+    begin(dir, peer, len);
+    append(data, len);
+}
+
+bool CaptureReader::open(const char* path) {
+    f = fopen(path, "rb");
+    if (!f) return false;
+    PcapHeader h;
+    if (fread(&h, sizeof h, 1, f) != 1) return false;
+    swapped = h.magic == bswap(Capture::MAGIC_NS);
+    if (h.magic != Capture::MAGIC_NS && !swapped) return false;
+    uint32_t link = swapped ? bswap(h.network) : h.network;
+    return link == Capture::LINKTYPE_USER0;
+}
+
+bool CaptureReader::next(Entry& e) {
+    PcapRecord r;
+    if (!f || fread(&r, sizeof r, 1, f) != 1) return false;
+    if (swapped) { r.sec = bswap(r.sec); r.nsec = bswap(r.nsec); r.inclLen = bswap(r.inclLen); }
+    if (r.inclLen < Capture::PSEUDO_SIZE || r.inclLen > SNAPLEN) return false;
+    rec.resize(r.inclLen);
+    if (fread(rec.data(), 1, rec.size(), f) != rec.size()) return false;
+
+    e.ns = uint64_t(r.sec) * 1000000000 + r.nsec;
+    e.dir = Capture::Dir(rec[0]);
+    e.peer = sockaddr_in{};
+    e.peer.sin_family = AF_INET;
+    memcpy(&e.peer.sin_port, &rec[2], 2);
+    memcpy(&e.peer.sin_addr.s_addr, &rec[4], 4);
+    e.data = rec.data() + Capture::PSEUDO_SIZE;
+    e.len = rec.size() - Capture::PSEUDO_SIZE;
+    return true;
+}
@@ -0,0 +1,90 @@
+#include "congestion.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @file    congestion.cpp
+ * @brief   Implementação dos controladores NewReno e CUBIC.
+ *
+ * Ambos compartilham slow start enquanto cwnd < ssthresh; a diferença
+ * está no crescimento em congestion avoidance e no fator de redução.
+ */
+
+using namespace std;
+
+void NewRenoController::onAck(uint32_t acked, uint64_t, double) {
+    if (cw < ssth) cw += min(acked, MSS);
+    else cw += max<uint32_t>(1, uint64_t(MSS) * acked / cw);
+}
+
+void NewRenoController::onLoss(uint64_t) {
+    ssth = max(cw / 2, 2 * MSS);
+    cw = ssth;
+}
+
+void NewRenoController::onTimeout(uint64_t) {
+    ssth = max(cw / 2, 2 * MSS);
+    cw = MSS;
+}
+
+/**
+ * @brief Crescimento em congestion avoidance segundo a função cúbica.
+ *
+ * W(t) = C·(t − K)³ + W_max, em MSS, avaliada um RTT à frente e limitada
+ * a 1,5·cwnd (RFC 9438 §4.2); a cwnd avança (W − cwnd)/cwnd por MSS
+ * confirmado, nunca abaixo do Reno estimado.
+ */
+void CubicController::onAck(uint32_t acked, uint64_t now, double srtt) {
+    if (cw < ssth) { cw += min(acked, MSS); return; }
+
+    double cwnd = double(cw) / MSS;
+    if (!epoch) {
+        epoch = now;
+        if (wMax < cwnd) { wMax = cwnd; k = 0; }
+        else k = cbrt((wMax - cwnd) / C);
+        wEst = cwnd;
+    }
+    double rtt = max(srtt, 1.0) / 1000.0;
+    double t = double(now - epoch) / 1000.0 + rtt;
+    double target = C * pow(t - k, 3) + wMax;
+
+    double segs = double(acked) / MSS;
+    wEst += 3 * (1 - BETA) / (1 + BETA) * segs / cwnd;
+    target = min(max(target, wEst), 1.5 * cwnd);
+
+    double inc = target > cwnd ? (target - cwnd) / cwnd * segs : 0.01 * segs / cwnd;
+    double next = max(double(cw) + inc * MSS, double(cw) + 1);
+    cw = uint32_t(min(next, double(MAX_CWND)));
+}
+
+void CubicController::reduce() {
+    double cwnd = double(cw) / MSS;
+    // convergência rápida: cede banda se a perda veio antes de alcançar wMax
+    wMax = cwnd < wMax ? cwnd * (1 + BETA) / 2 : cwnd;
+    ssth = max<uint32_t>(uint32_t(cw * BETA), 2 * MSS);
+    epoch = 0;
+}
+
+void CubicController::onLoss(uint64_t) {
+    reduce();
+    cw = ssth;
+}
+
+void CubicController::onTimeout(uint64_t) {
+    reduce();
+    cw = MSS;
+}
+
+/**
+ * @brief Ocioso ou limitado pela aplicação: a época recomeça no próximo
+ *        ACK, senão t contaria o tempo parado e a cúbica dispararia.
+ */
+void CubicController::onIdle(uint64_t) {
+    epoch = 0;
+}
+
+unique_ptr<CongestionController> makeCongestionController(const string& name) {
+    if (name == "reno" || name == "newreno") return make_unique<NewRenoController>();
+    if (name == "cubic") return make_unique<CubicController>();
+    return nullptr;
+}
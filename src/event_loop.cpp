@@ -0,0 +1,409 @@
+#include "event_loop.h"
+#include "log.h"
+#include "metrics.h"
+#include "session_manager.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @file    event_loop.cpp
+ * @brief   Implementação do laço de eventos multi-sessão.
+ *
+ * Cada conexão agenda na roda de timers apenas o seu menor deadline
+ * (retransmissão ou timeout de estado); o timerfd fica armado no menor
+ * de todos. Assim o custo de um tick é proporcional às conexões que de
+ * fato venceram, não ao total. Os keep-alives usam uma segunda roda
+ * pelo mesmo motivo: só as sessões ociosas perto do STTL custam algo.
+ */
+
+Connection::Connection(uint32_t i, const sockaddr_in& srv, Handlers hs)
+: id(i), tx(net, srv, sess), h(std::move(hs)) {}
+
+size_t EventLoop::SidHash::operator()(const array<uint8_t, UUID_SIZE>& s) const {
+    // UUIDs v8 são aleatórios: os primeiros 8 bytes já espalham bem
+    uint64_t v;
+    memcpy(&v, s.data(), sizeof v);
+    return size_t(v);
+}
+
+EventLoop::EventLoop(const sockaddr_in& server, size_t rxSlots)
+: srv(server), rxq(rxSlots), rx(Network::MAX_BATCH) {
+    rxq.onMessage([this](ByteSpan sid, uint8_t, ByteSpan msg) {
+        array<uint8_t, UUID_SIZE> key;
+        copy(sid.begin(), sid.end(), key.begin());
+        auto it = bySid.find(key);
+        if (it != bySid.end() && it->second->h.onMessage) it->second->h.onMessage(*it->second, msg);
+    });
+}
+
+EventLoop::~EventLoop() {
+    conns.clear();
+    if (tfd >= 0) ::close(tfd);
+    if (epfd >= 0) ::close(epfd);
+    if (io) io->close();
+}
+
+bool EventLoop::open(const string& backend) {
+    io = makeTransport(backend);
+    if (!io || !io->open()) return false;
+    io->wait(0); // backends que precisam postar a recepção antes (uring)
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epfd < 0 || tfd < 0) return false;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = io->pollFd();
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) return false;
+    ev.data.fd = tfd;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &ev) == 0;
+}
+
+/**
+ * @brief Troca o estado mantendo a contagem de conexões ativas.
+ */
+void EventLoop::setState(Connection& c, Connection::State s) {
+    bool wasLive = c.state != Connection::State::Closed;
+    bool isLive = s != Connection::State::Closed;
+    live += size_t(isLive) - size_t(wasLive);
+    c.state = s;
+}
+
+Connection* EventLoop::connect(Connection::Handlers h) {
+    uint32_t id = nextId++;
+    auto& c = *(conns[id] = make_unique<Connection>(id, srv, std::move(h)));
+    ++live;
+    c.sess.recvWindow = rxq.window();
+    c.net.attach(io);
+    c.net.setReassembler(&rxq);
+    c.net.setCapture(cap);
+
+    uint32_t dummy;
+    c.net.sendPacket(srv, makeConnect(c.sess), dummy, c.sess);
+    handshaking.push_back(id);
+    c.deadline = nowMs() + STATE_TIMEOUT_MS;
+    arm(c);
+    return &c;
+}
+
+void EventLoop::release(Connection& c) {
+    rxq.forget(c.sess);
+    auto it = bySid.find(c.sess.sid);
+    if (it != bySid.end() && it->second == &c) bySid.erase(it);
+    setState(c, Connection::State::Closed);
+    released.push_back(c.id);
+}
+
+bool EventLoop::send(Connection& c, vector<uint8_t> msg) {
+    if (c.state == Connection::State::Closing || c.state == Connection::State::Closed) return false;
+    c.outbox.push_back(std::move(msg));
+    if (c.state == Connection::State::Open) { pump(c); arm(c); }
+    return true;
+}
+
+void EventLoop::disconnect(Connection& c) {
+    if (c.state != Connection::State::Open) return;
+    c.outbox.clear();
+    c.sending = false;
+    uint32_t dummy;
+    c.net.sendPacket(srv, makeDisconnect(c.sess), dummy, c.sess);
+    setState(c, Connection::State::Closing);
+    c.deadline = nowMs() + STATE_TIMEOUT_MS;
+    arm(c);
+}
+
+void EventLoop::revive(Connection& c, const string& payload) {
+    if (c.state != Connection::State::Closed || c.sess.sid == Session::nilUUID()) return;
+    c.net.resetFlight(c.sess);
+    uint32_t dummy;
+    c.net.sendPacket(srv, makeRevive(c.sess, payload), dummy, c.sess);
+    setState(c, Connection::State::Reviving);
+    c.deadline = nowMs() + STATE_TIMEOUT_MS;
+    arm(c);
+}
+
+/**
+ * @brief Encerra localmente e avisa a aplicação.
+ */
+void EventLoop::close(Connection& c, bool graceful) {
+    c.net.resetFlight(c.sess);
+    c.sess.connected = false;
+    c.sending = false;
+    c.deadline = TimerWheel::NONE;
+    rxq.forget(c.sess);
+    setState(c, Connection::State::Closed);
+    if (c.h.onClosed) c.h.onClosed(c, graceful);
+}
+
+/**
+ * @brief Avança a mensagem em curso e inicia as seguintes da fila.
+ */
+void EventLoop::pump(Connection& c) {
+    while (c.state == Connection::State::Open) {
+        if (!c.sending) {
+            if (c.outbox.empty()) break;
+            // maior que MAX_FRAGS fragmentos: descartada (ver BulkTransfer)
+            if (!c.tx.begin(c.outbox.front().data(), c.outbox.front().size())) {
+                c.outbox.pop_front();
+                continue;
+            }
+            c.sending = true;
+        }
+        c.tx.fill();
+        if (!c.tx.done()) break;
+        size_t n = c.outbox.front().size();
+        c.outbox.pop_front();
+        c.sending = false;
+        // com fragmento descartado a mensagem não chegou inteira
+        if (c.h.onSent && !c.tx.lost()) c.h.onSent(c, n);
+    }
+    // janela fechada: fill() armou o persist timer, que o onTimer da Network atende
+    c.deadline = TimerWheel::NONE;
+}
+
+/**
+ * @brief Máquina de estados de uma conexão diante de um pacote recebido.
+ */
+void EventLoop::step(Connection& c, const SlowPacketView& pkt) {
+    switch (c.state) {
+    case Connection::State::Handshake:
+        if (!applySetup(pkt, c.sess)) break;
+        bySid[c.sess.sid] = &c;
+        c.net.deferAck(srv); // vai de carona no primeiro dado, se houver
+        setState(c, Connection::State::Open);
+        c.deadline = TimerWheel::NONE;
+        if (c.h.onOpen) c.h.onOpen(c);
+        pump(c);
+        break;
+    case Connection::State::Open:
+        if (c.sending) c.tx.onAck(pkt);
+        pump(c);
+        break;
+    case Connection::State::Reviving:
+        if (!applyRevive(pkt, c.sess)) { close(c, false); break; }
+        c.net.resetFlight(c.sess);
+        setState(c, Connection::State::Open);
+        c.deadline = TimerWheel::NONE;
+        if (c.h.onOpen) c.h.onOpen(c);
+        pump(c);
+        break;
+    case Connection::State::Closing:
+        if (pkt.flags & ACK) close(c, true);
+        break;
+    case Connection::State::Closed:
+        break;
+    }
+}
+
+/**
+ * @brief Entrega um datagrama à conexão dona do SID.
+ *
+ * Um SID desconhecido só é aceito se o pacote trouxer ACCEPT: é o SETUP
+ * de algum handshake, e vai para o CONNECT pendente mais antigo.
+ */
+void EventLoop::dispatch(const Datagram& dg) {
+    if (dg.len < size_t(HDR_SIZE)) return;
+    array<uint8_t, UUID_SIZE> sid;
+    memcpy(sid.data(), dg.data, UUID_SIZE);
+
+    Connection* c = nullptr;
+    auto it = bySid.find(sid);
+    if (it != bySid.end()) c = it->second;
+    else if (dg.data[UUID_SIZE] & ACCEPT) {
+        while (!c && !handshaking.empty()) {
+            auto f = conns.find(handshaking.front());
+            handshaking.pop_front();
+            if (f != conns.end() && f->second->state == Connection::State::Handshake) c = f->second.get();
+        }
+    }
+    if (!c) return;
+
+    SlowPacketView pkt;
+    if (!c->net.onDatagram(dg, pkt, c->sess)) return;
+    step(*c, pkt);
+    if (c->h.onPacket) c->h.onPacket(*c, pkt);
+    arm(*c);
+    keep(*c);
+}
+
+/**
+ * @brief Agenda o menor deadline da conexão, se for anterior ao já agendado.
+ */
+void EventLoop::arm(Connection& c) {
+    if (c.state == Connection::State::Closed) return;
+    uint64_t wake = min(c.net.nextDeadline(), c.deadline);
+    if (wake == TimerWheel::NONE || wake >= c.armed) return;
+    c.armed = wake;
+    wheel.schedule(c.id, wake);
+}
+
+/**
+ * @brief Agenda o keep-alive de uma conexão aberta que ainda não tem um.
+ *
+ * O cancelamento é preguiçoso: como lastHeard só avança, basta conferir
+ * o prazo de novo quando a entrada vencer.
+ */
+void EventLoop::keep(Connection& c) {
+    if (!keepAlive || c.state != Connection::State::Open || c.keepAt != TimerWheel::NONE) return;
+    uint64_t due = keepAliveDue(c.net, c.sess);
+    if (due == TimerWheel::NONE) return;
+    c.keepAt = due;
+    idle.schedule(c.id, due);
+}
+
+/**
+ * @brief Trata os keep-alives vencidos até `now` (mais a folga).
+ *
+ * Conexões ociosas mandam um pure-ACK, serializado direto do Session
+ * e enviado junto com os das outras num só send(); se o STTL já venceu
+ * sem resposta, a conexão passa a Reviving sem avisar a aplicação.
+ * Uma resposta perdida é repetida a cada STTL/8.
+ */
+void EventLoop::keepAlives(uint64_t now) {
+    expired.clear();
+    idle.expire(now + KEEPALIVE_SLACK_MS, expired);
+    keepHdr.clear();
+    for (uint32_t id : expired) {
+        auto it = conns.find(id);
+        if (it == conns.end()) continue;
+        Connection& c = *it->second;
+        c.keepAt = TimerWheel::NONE;
+        uint64_t due = keepAliveDue(c.net, c.sess);
+        if (!keepAlive || c.state != Connection::State::Open || due == TimerWheel::NONE) continue;
+
+        uint64_t retry = now + max<uint64_t>(c.sess.sttl / 8, 1);
+        if (due > now + min<uint64_t>(KEEPALIVE_SLACK_MS, c.sess.sttl / 8)) c.keepAt = due;
+        else if (presumedExpired(c.net, c.sess, now)) {
+            SLOW_LOG(Info, Session, "[loop] conexão {} sem notícias há um STTL, revive em segundo plano", c.id);
+            setState(c, Connection::State::Closed);
+            revive(c);
+            continue;
+        }
+        else if (c.sending || c.net.pendingCount()) c.keepAt = retry; // o tráfego em curso já renova a sessão
+        else {
+            SlowPacketView a;
+            a.sid = ByteSpan(c.sess.sid.data(), c.sess.sid.size());
+            a.flags = ACK;
+            a.seqnum = c.sess.seqnum;
+            a.acknum = c.sess.acknum;
+            a.window = c.sess.recvWindow;
+            a.sttl = c.sess.sttl;
+            keepHdr.emplace_back();
+            a.serializeHeader(keepHdr.back().data());
+            c.keepAt = retry;
+        }
+        idle.schedule(c.id, c.keepAt);
+    }
+    if (keepHdr.empty()) return;
+
+    SLOW_LOG(Debug, Session, "[loop] {} keep-alives", keepHdr.size());
+    OutDatagram d[Network::MAX_BATCH];
+    for (size_t i = 0; i < keepHdr.size(); i += Network::MAX_BATCH) {
+        size_t n = min(keepHdr.size() - i, Network::MAX_BATCH);
+        for (size_t k = 0; k < n; ++k) {
+            d[k].iov[0] = {keepHdr[i + k].data(), HDR_SIZE};
+            if (cap) cap->record(Capture::Tx, srv, d[k]);
+        }
+        size_t sent = io->send(srv, d, n);
+        metrics::add(metrics::Counter::TxPackets, sent);
+        metrics::add(metrics::Counter::TxBytes, sent * HDR_SIZE);
+        metrics::add(metrics::Counter::KeepAlives, sent);
+    }
+}
+
+void EventLoop::onTimer(uint64_t now) {
+    expired.clear();
+    wheel.expire(now, expired);
+    for (uint32_t id : expired) {
+        auto it = conns.find(id);
+        if (it == conns.end()) continue;
+        Connection& c = *it->second;
+        c.armed = TimerWheel::NONE;
+        if (c.state == Connection::State::Closed) continue;
+        c.net.onTimer(c.sess);
+        if (c.deadline <= now) {
+            if (c.state == Connection::State::Open) pump(c);
+            else {
+                SLOW_LOG(Warn, Session, "[loop] conexão {} sem resposta, encerrando", c.id);
+                close(c, false);
+            }
+        }
+        arm(c);
+    }
+    keepAlives(now);
+}
+
+/**
+ * @brief Arma o timerfd no próximo deadline da roda (ou o desarma).
+ */
+void EventLoop::rearmTimer() {
+    itimerspec ts{};
+    uint64_t next = nextDeadline();
+    if (next != TimerWheel::NONE) {
+        uint64_t now = nowMs();
+        uint64_t rel = next > now ? next - now : 0;
+        ts.it_value.tv_sec = time_t(rel / 1000);
+        ts.it_value.tv_nsec = long(rel % 1000) * 1000000;
+        if (!rel) ts.it_value.tv_nsec = 1; // zero desarmaria
+    }
+    timerfd_settime(tfd, 0, &ts, nullptr);
+}
+
+void EventLoop::reap() {
+    for (uint32_t id : released) conns.erase(id);
+    released.clear();
+}
+
+/**
+ * @brief Entrega todos os datagramas que o backend já tem.
+ *
+ * O lote inteiro é processado antes do próximo recv(): os buffers do
+ * backend só são reaproveitados depois disso.
+ * @return quantidade de datagramas lidos.
+ */
+size_t EventLoop::drain() {
+    size_t got, total = 0;
+    while ((got = io->recv(rx.data(), rx.size())) > 0) {
+        for (size_t k = 0; k < got; ++k) dispatch(rx[k]);
+        total += got;
+    }
+    return total;
+}
+
+int EventLoop::runOnce(int timeoutMs) {
+    // um envio pode ter colhido recepções (uring) sem deixar o fd legível
+    int handled = int(drain());
+    rearmTimer();
+    epoll_event ev[2];
+    int n = epoll_wait(epfd, ev, 2, handled ? 0 : timeoutMs);
+    if (n < 0) return errno == EINTR ? handled : -1;
+    for (int i = 0; i < n; ++i) {
+        if (ev[i].data.fd == tfd) {
+            uint64_t ticks;
+            if (::read(tfd, &ticks, sizeof ticks) < 0) continue;
+        } else handled += int(drain());
+    }
+    onTimer(nowMs());
+    reap();
+    return handled + n;
+}
+
+size_t EventLoop::poll(uint64_t now) {
+    size_t n = drain();
+    onTimer(now);
+    reap();
+    return n;
+}
+
+void EventLoop::run() {
+    running = true;
+    while (running && live)
+        if (runOnce() < 0) {
+            SLOW_LOG(Error, Io, "[loop] epoll_wait: {}", strerror(errno));
+            break;
+        }
+}
@@ -0,0 +1,47 @@
+#include "flow_control.h"
+#include <algorithm>
+
+/**
+ * @file    flow_control.cpp
+ * @brief   Implementação do persist timer e do atraso de ACKs.
+ */
+
+void FlowControl::blocked(uint64_t now, uint64_t rto, uint32_t n) {
+    need = std::max<uint32_t>(n, 1);
+    if (persistAt != NONE) return;
+    interval = std::min(std::max<uint64_t>(rto, 1), MAX_PERSIST_MS);
+    persistAt = now + interval;
+}
+
+void FlowControl::opened(uint32_t window) {
+    if (window < need) return; // ainda não cabe: mantém o backoff
+    persistAt = NONE;
+    interval = 0;
+}
+
+bool FlowControl::probeDue(uint64_t now) {
+    if (now < persistAt) return false;
+    interval = std::min(interval * 2, MAX_PERSIST_MS);
+    persistAt = now + interval;
+    return true;
+}
+
+void FlowControl::received(uint64_t now) {
+    defer(now);
+    ++unacked;
+}
+
+void FlowControl::defer(uint64_t now) {
+    if (ackAt == NONE) ackAt = now + ACK_DELAY_MS;
+}
+
+void FlowControl::acked() {
+    ackAt = NONE;
+    unacked = 0;
+}
+
+void FlowControl::reset() {
+    need = 1;
+    opened(UINT32_MAX);
+    acked();
+}
@@ -0,0 +1,59 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @file    histogram.cpp
+ * @brief   Implementação do histograma log-linear.
+ *
+ * Faixa b < 2·SUB vale exatamente b. Acima disso, com `shift` tal que
+ * v >> shift cai em [SUB, 2·SUB), a faixa é shift·SUB + (v >> shift):
+ * os índices seguem contíguos de uma oitava para a próxima.
+ */
+
+size_t Histogram::bucketOf(uint64_t v) {
+    if (v < 2 * SUB) return size_t(v);
+    int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+    return size_t(shift) * SUB + size_t(v >> shift);
+}
+
+uint64_t Histogram::lowerBound(size_t b) {
+    if (b < 2 * SUB) return b;
+    size_t shift = b / SUB - 1;
+    return uint64_t(b - shift * SUB) << shift;
+}
+
+uint64_t Histogram::upperBound(size_t b) {
+    if (b < 2 * SUB) return b;
+    size_t shift = b / SUB - 1;
+    return lowerBound(b) + ((uint64_t(1) << shift) - 1);
+}
+
+void Histogram::record(uint64_t v, uint64_t n) {
+    counts[bucketOf(v)] += n;
+    total += n;
+    sum += v * n;
+    lo = std::min(lo, v);
+    hi = std::max(hi, v);
+}
+
+void Histogram::merge(const Histogram& o) {
+    for (size_t i = 0; i < BUCKETS; ++i) counts[i] += o.counts[i];
+    total += o.total;
+    sum += o.sum;
+    lo = std::min(lo, o.lo);
+    hi = std::max(hi, o.hi);
+}
+
+void Histogram::reset() { *this = Histogram(); }
+
+uint64_t Histogram::percentile(double q) const {
+    if (!total) return 0;
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(std::clamp(q, 0.0, 1.0) * double(total))));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        seen += counts[b];
+        if (seen >= rank) return std::min(upperBound(b), hi);
+    }
+    return hi;
+}
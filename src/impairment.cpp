@@ -0,0 +1,256 @@
+#include "impairment.h"
+#include "slow.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+/**
+ * @file    impairment.cpp
+ * @brief   Implementação do ImpairedTransport e do parser de perfis.
+ *
+ * Cada ImpairedLink é uma fila de prioridade por instante de saída. Um pacote
+ * admitido sai em linkFree + atraso + jitter, onde linkFree avança com o
+ * tempo de serialização quando há limite de banda; os reordenados ganham
+ * mais um atraso (no mínimo 1 ms) e os duplicados entram duas vezes.
+ */
+
+namespace {
+
+uint64_t nowUs() {
+    using namespace std::chrono;
+    return uint64_t(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+ImpairedTransport::ImpairedTransport(shared_ptr<Transport> inner, const Config& cfg)
+    : inner(std::move(inner)), tx(cfg.tx, cfg.seed), rx(cfg.rx, cfg.seed ^ 0x9e3779b97f4a7c15ULL),
+      inbox(UdpTransport::BATCH) {}
+
+/**
+ * @brief Sorteia a perda pelo modelo de Gilbert-Elliott.
+ *
+ * No estado bom nada se perde e no ruim tudo se perde. Saindo do ruim
+ * com probabilidade 1/burst, as rajadas têm tamanho médio `burst`; a
+ * entrada loss/(burst·(1 − loss)) faz a fração de tempo no estado ruim
+ * ser exatamente `loss`.
+ */
+bool ImpairedLink::lose() {
+    if (cfg.loss <= 0) return false;
+    if (cfg.loss >= 1) return true;
+    if (cfg.burst <= 1) return uniform() < cfg.loss;
+    double u = uniform();
+    if (bad) bad = u >= 1 / cfg.burst;
+    else bad = u < cfg.loss / (cfg.burst * (1 - cfg.loss));
+    return bad;
+}
+
+vector<uint8_t> ImpairedLink::buffer() {
+    if (spare.empty()) return {};
+    vector<uint8_t> b = std::move(spare.back());
+    spare.pop_back();
+    b.clear();
+    return b;
+}
+
+void ImpairedLink::recycle(vector<uint8_t>&& b) {
+    if (b.capacity()) spare.push_back(std::move(b));
+}
+
+void ImpairedLink::push(Packet&& p) {
+    q.push_back(std::move(p));
+    push_heap(q.begin(), q.end(), Later());
+}
+
+ImpairedLink::Packet ImpairedLink::pop() {
+    pop_heap(q.begin(), q.end(), Later());
+    Packet p = std::move(q.back());
+    q.pop_back();
+    return p;
+}
+
+void ImpairedLink::clear() {
+    for (Packet& p : q) recycle(std::move(p.bytes));
+    q.clear();
+    linkFree = 0;
+}
+
+void ImpairedLink::admit(const sockaddr_in& addr, const iovec* iov, size_t iovcnt, uint64_t now) {
+    if (lose()) { ++stats.lost; return; }
+    if (q.size() >= cfg.queue) { ++stats.overflow; return; }
+
+    Packet p{0, order++, addr, buffer()};
+    for (size_t i = 0; i < iovcnt; ++i) {
+        const uint8_t* b = static_cast<const uint8_t*>(iov[i].iov_base);
+        p.bytes.insert(p.bytes.end(), b, b + iov[i].iov_len);
+    }
+
+    uint64_t start = now;
+    if (cfg.rateBps) {
+        linkFree = max(linkFree, now) + p.bytes.size() * 8 * 1000000 / cfg.rateBps;
+        start = linkFree;
+    }
+    p.due = start + cfg.delayUs;
+    if (cfg.jitterUs) p.due += uint64_t(uniform() * double(cfg.jitterUs));
+    if (cfg.reorder > 0 && uniform() < cfg.reorder) {
+        p.due += max<uint64_t>(cfg.delayUs, 1000);
+        ++stats.reordered;
+    }
+    ++stats.passed;
+
+    if (cfg.duplicate > 0 && uniform() < cfg.duplicate) {
+        Packet dup{p.due, order++, addr, buffer()};
+        dup.bytes.assign(p.bytes.begin(), p.bytes.end());
+        push(std::move(dup));
+        ++stats.duplicated;
+    }
+    push(std::move(p));
+}
+
+void ImpairedTransport::close() {
+    inner->close();
+    tx.clear();
+    rx.clear();
+}
+
+/**
+ * @brief Entrega ao backend real tudo o que já venceu na fila de envio,
+ *        agrupando destinos iguais num único send().
+ */
+void ImpairedTransport::flushTx(uint64_t now) {
+    while (tx.due(now)) outbox.push_back(tx.pop());
+    for (size_t i = 0; i < outbox.size();) {
+        size_t j = i;
+        batch.clear();
+        while (j < outbox.size() && outbox[j].addr.sin_addr.s_addr == outbox[i].addr.sin_addr.s_addr &&
+               outbox[j].addr.sin_port == outbox[i].addr.sin_port) {
+            OutDatagram d;
+            d.iov[0] = {outbox[j].bytes.data(), outbox[j].bytes.size()};
+            batch.push_back(d);
+            ++j;
+        }
+        inner->send(outbox[i].addr, batch.data(), batch.size());
+        i = j;
+    }
+    for (auto& p : outbox) tx.recycle(std::move(p.bytes));
+    outbox.clear();
+}
+
+/**
+ * @brief Drena o backend real para a fila de recepção.
+ */
+void ImpairedTransport::pullRx(uint64_t now) {
+    for (;;) {
+        size_t n = inner->recv(inbox.data(), inbox.size());
+        for (size_t i = 0; i < n; ++i) {
+            iovec v{const_cast<uint8_t*>(inbox[i].data), inbox[i].len};
+            rx.admit(inbox[i].from, &v, 1, now);
+        }
+        if (n < inbox.size()) break;
+    }
+}
+
+/**
+ * @brief Os datagramas sempre "saem": perdas acontecem no enlace simulado.
+ */
+size_t ImpairedTransport::send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) {
+    uint64_t now = nowUs();
+    for (size_t i = 0; i < n; ++i) tx.admit(to, dgrams[i].iov, 2, now);
+    flushTx(now);
+    return n;
+}
+
+/**
+ * @brief Espera por datagramas vencidos na fila de recepção, acordando
+ *        também nos vencimentos da fila de envio para liberá-los a tempo.
+ */
+bool ImpairedTransport::wait(uint64_t timeoutMs) {
+    uint64_t end = nowUs() + timeoutMs * 1000;
+    for (;;) {
+        uint64_t now = nowUs();
+        flushTx(now);
+        pullRx(now);
+        if (rx.due(now)) return true;
+        if (now >= end) return false;
+        uint64_t next = min({end, rx.nextDue(), tx.nextDue()});
+        inner->wait((next - now + 999) / 1000);
+    }
+}
+
+size_t ImpairedTransport::recv(Datagram* out, size_t max) {
+    for (auto& b : delivered) rx.recycle(std::move(b));
+    delivered.clear();
+    uint64_t now = nowUs();
+    flushTx(now);
+    pullRx(now);
+    size_t got = 0;
+    while (got < max && rx.due(now)) {
+        ImpairedLink::Packet p = rx.pop();
+        delivered.push_back(std::move(p.bytes));
+        out[got].data = delivered.back().data();
+        out[got].len = delivered.back().size();
+        out[got].from = p.addr;
+        ++got;
+    }
+    return got;
+}
+
+namespace {
+
+/**
+ * @brief Número com sufixo opcional k/m/g (potências de 1000).
+ */
+bool parseNumber(const string& s, double& out) {
+    if (s.empty()) return false;
+    char* end;
+    out = strtod(s.c_str(), &end);
+    switch (*end) {
+    case 'k': case 'K': out *= 1e3; ++end; break;
+    case 'm': case 'M': out *= 1e6; ++end; break;
+    case 'g': case 'G': out *= 1e9; ++end; break;
+    default: break;
+    }
+    return !*end && out >= 0;
+}
+
+bool setLink(ImpairedTransport::Link& l, const string& key, double v) {
+    if (key == "loss") { if (v > 1) return false; l.loss = v; }
+    else if (key == "burst") l.burst = v;
+    else if (key == "delay") l.delayUs = uint64_t(v * 1000);
+    else if (key == "jitter") l.jitterUs = uint64_t(v * 1000);
+    else if (key == "reorder") { if (v > 1) return false; l.reorder = v; }
+    else if (key == "dup") { if (v > 1) return false; l.duplicate = v; }
+    else if (key == "rate") l.rateBps = uint64_t(v);
+    else if (key == "queue") { if (v < 1) return false; l.queue = size_t(v); }
+    else return false;
+    return true;
+}
+
+} // namespace
+
+bool parseImpairment(const string& spec, ImpairedTransport::Config& out) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == string::npos) comma = spec.size();
+        string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string key = item.substr(0, eq);
+        double v;
+        if (!parseNumber(item.substr(eq + 1), v)) return false;
+
+        if (key == "seed") { out.seed = uint64_t(v); continue; }
+        bool toTx = true, toRx = true;
+        if (key.rfind("tx.", 0) == 0) { toRx = false; key.erase(0, 3); }
+        else if (key.rfind("rx.", 0) == 0) { toTx = false; key.erase(0, 3); }
+        if (toTx && !setLink(out.tx, key, v)) return false;
+        if (toRx && !setLink(out.rx, key, v)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,371 @@
+#include "log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * @file    log.cpp
+ * @brief   Fila sem locks, thread de formatação e sinks do log.
+ *
+ * A fila é o anel limitado de Vyukov: cada célula tem um número de
+ * sequência que diz se ela está livre para o produtor da volta atual ou
+ * pronta para o consumidor. Vários produtores disputam a posição com um
+ * CAS; o consumidor (a thread de fundo) é único.
+ */
+
+namespace slowlog {
+
+namespace {
+
+constexpr size_t RING_SIZE = 4096; // Registros (potência de 2)
+constexpr auto IDLE_SLEEP = chrono::microseconds(200);
+
+struct Cell {
+    atomic<size_t> seq;
+    Record rec;
+};
+
+/**
+ * @brief Estado global do log; a thread nasce no primeiro registro.
+ */
+class Logger {
+public:
+    Logger() : cells(RING_SIZE) {
+        for (size_t i = 0; i < RING_SIZE; ++i) cells[i].seq.store(i, memory_order_relaxed);
+        for (auto& l : levels) l.store(uint8_t(Level::Trace), memory_order_relaxed);
+        sinks.push_back(makeBoxSink(cout, cerr));
+        epoch = detail::now();
+    }
+    ~Logger() {
+        stopping.store(true, memory_order_release);
+        if (worker.joinable()) worker.join();
+    }
+
+    Record* claim(size_t& pos) {
+        pos = enq.load(memory_order_relaxed);
+        while (true) {
+            Cell& c = cells[pos & (RING_SIZE - 1)];
+            size_t seq = c.seq.load(memory_order_acquire);
+            intptr_t dif = intptr_t(seq) - intptr_t(pos);
+            if (dif == 0) {
+                if (enq.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    start();
+                    return &c.rec;
+                }
+            } else if (dif < 0) {
+                lost.fetch_add(1, memory_order_relaxed);
+                return nullptr;
+            } else pos = enq.load(memory_order_relaxed);
+        }
+    }
+
+    void publish(size_t pos) {
+        cells[pos & (RING_SIZE - 1)].seq.store(pos + 1, memory_order_release);
+    }
+
+    void flush() {
+        if (!running.load(memory_order_acquire)) return;
+        size_t target = enq.load(memory_order_acquire);
+        while (done.load(memory_order_acquire) < target) this_thread::sleep_for(IDLE_SLEEP);
+    }
+
+    void setSinks(unique_ptr<Sink> s, bool replace) {
+        lock_guard<mutex> g(sinkMu);
+        if (replace) sinks.clear();
+        if (s) sinks.push_back(std::move(s));
+    }
+
+    atomic<uint8_t> levels[size_t(Cat::Count)];
+    atomic<uint64_t> lost{0};
+    uint64_t epoch = 0;
+
+private:
+    void start() {
+        if (running.load(memory_order_acquire)) return;
+        lock_guard<mutex> g(startMu);
+        if (running.load(memory_order_relaxed)) return;
+        worker = thread([this] { run(); });
+        running.store(true, memory_order_release);
+    }
+
+    bool pop(Record& out) {
+        Cell& c = cells[deq & (RING_SIZE - 1)];
+        if (c.seq.load(memory_order_acquire) != deq + 1) return false;
+        out = c.rec;
+        c.seq.store(deq + RING_SIZE, memory_order_release);
+        ++deq;
+        return true;
+    }
+
+    void run() {
+        Record r;
+        uint64_t reported = 0;
+        while (true) {
+            bool any = false;
+            {
+                lock_guard<mutex> g(sinkMu);
+                while (pop(r)) {
+                    for (auto& s : sinks) s->write(r);
+                    done.store(deq, memory_order_release);
+                    any = true;
+                }
+                uint64_t l = lost.load(memory_order_relaxed);
+                if (l != reported) {
+                    cerr << "[log] " << l - reported << " registros descartados (fila cheia)\n";
+                    reported = l;
+                }
+                if (any) for (auto& s : sinks) s->flush();
+            }
+            if (any) continue;
+            if (stopping.load(memory_order_acquire) && deq == enq.load(memory_order_acquire)) break;
+            this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+
+    vector<Cell> cells;
+    alignas(64) atomic<size_t> enq{0};
+    alignas(64) size_t deq = 0;       // Só a thread de fundo
+    atomic<size_t> done{0};           // Registros já entregues aos sinks
+    atomic<bool> running{false};
+    atomic<bool> stopping{false};
+    mutex startMu;
+    mutex sinkMu;
+    vector<unique_ptr<Sink>> sinks;
+    thread worker;
+};
+
+Logger& logger() {
+    static Logger l;
+    return l;
+}
+
+/**
+ * @brief Substitui cada `{}` de `fmt` pelo argumento seguinte.
+ */
+void format(const Record& r, string& out) {
+    size_t arg = 0;
+    for (const char* p = r.fmt; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && arg < r.nargs) {
+            char num[32];
+            switch (r.types[arg]) {
+            case Record::Int: snprintf(num, sizeof num, "%lld", (long long)r.args[arg].i); out += num; break;
+            case Record::Uint: snprintf(num, sizeof num, "%llu", (unsigned long long)r.args[arg].u); out += num; break;
+            case Record::Dbl: snprintf(num, sizeof num, "%.3f", r.args[arg].d); out += num; break;
+            case Record::Str: out += r.text + r.args[arg].u; break;
+            }
+            ++arg;
+            ++p;
+        } else out += *p;
+    }
+}
+
+void appendSid(const PacketHdr& h, string& out) {
+    static const char hex[] = "0123456789abcdef";
+    for (uint8_t b : h.sid) { out += hex[b >> 4]; out += hex[b & 15]; }
+}
+
+/**
+ * @brief A "caixa" histórica de logPacket, montada num único buffer.
+ */
+class BoxSink : public Sink {
+public:
+    BoxSink(ostream& o, ostream& e) : out(o), err(e) {}
+
+    void write(const Record& r) override {
+        buf.clear();
+        if (!r.packet) {
+            format(r, buf);
+            buf += '\n';
+            (r.level >= Level::Warn ? err : out) << buf;
+            return;
+        }
+        const PacketHdr& h = r.hdr;
+        string rows[4];
+        rows[0] = "SID  : ";
+        appendSid(h, rows[0]);
+        char tmp[96];
+        string fl = flagsToString(h.flags);
+        if (fl.size() < 3) fl.resize(3, ' ');
+        snprintf(tmp, sizeof tmp, "FLG  : %s  STTL: %u", fl.c_str(), h.sttl);
+        rows[1] = tmp;
+        snprintf(tmp, sizeof tmp, "SEQ  : %u   ACK : %u", h.seqnum, h.acknum);
+        rows[2] = tmp;
+        snprintf(tmp, sizeof tmp, "WIN  : %u   FID/FO: %u/%u", h.window, h.fid, h.fo);
+        rows[3] = tmp;
+
+        int boxW = 0;
+        for (auto& row : rows) boxW = max(boxW, int(row.size()));
+        boxW += 4;
+        hLine("╔", "╗", boxW, r.fmt);
+        for (auto& row : rows) vLine(row, boxW);
+        hLine("╚", "╝", boxW, nullptr);
+        buf += '\n';
+        if (h.dataLen) {
+            buf += "✉  DATA (" + to_string(h.dataLen) + " B): \"";
+            buf.append(r.text, r.textLen);
+            buf += h.dataLen > r.textLen ? "…\"\n\n" : "\"\n\n";
+        }
+        out << buf;
+    }
+    void flush() override { out.flush(); err.flush(); }
+
+private:
+    void hLine(const char* l, const char* r, int w, const char* title) {
+        buf += l;
+        int fill = w - 2;
+        if (title && *title) {
+            buf += ' '; buf += title; buf += ' ';
+            fill -= int(char_traits<char>::length(title)) + 2;
+        }
+        while (fill-- > 0) buf += "═";
+        buf += r;
+        buf += '\n';
+    }
+    void vLine(const string& body, int w) {
+        buf += "║ ";
+        buf += body;
+        buf.append(size_t(max(0, w - 3 - int(body.size()))), ' ');
+        buf += "║\n";
+    }
+
+    ostream& out;
+    ostream& err;
+    string buf;
+};
+
+class LineSink : public Sink {
+public:
+    explicit LineSink(FILE* f) : out(f) {}
+
+    void write(const Record& r) override {
+        buf.clear();
+        char head[64];
+        double t = double(r.ns - logger().epoch) / 1e9;
+        snprintf(head, sizeof head, "[%12.6f] %-5s %-7s ", t, levelName(r.level), catName(r.cat));
+        buf += head;
+        if (!r.packet) format(r, buf);
+        else {
+            const PacketHdr& h = r.hdr;
+            char tmp[128];
+            buf += r.fmt;
+            buf += " sid=";
+            appendSid(h, buf);
+            snprintf(tmp, sizeof tmp, " flags=%s seq=%u ack=%u win=%u fid=%u fo=%u len=%u",
+                     flagsToString(h.flags).c_str(), h.seqnum, h.acknum, h.window, h.fid, h.fo, h.dataLen);
+            buf += tmp;
+        }
+        buf += '\n';
+        fwrite(buf.data(), 1, buf.size(), out);
+    }
+    void flush() override { fflush(out); }
+
+private:
+    FILE* out;
+    string buf;
+};
+
+} // namespace
+
+const char* levelName(Level l) {
+    static const char* names[] = { "trace", "debug", "info", "warn", "error", "off" };
+    return names[size_t(l)];
+}
+
+const char* catName(Cat c) {
+    static const char* names[] = { "packet", "flow", "retx", "session", "io", "app" };
+    return c < Cat::Count ? names[size_t(c)] : "?";
+}
+
+unique_ptr<Sink> makeBoxSink(ostream& out, ostream& err) { return make_unique<BoxSink>(out, err); }
+unique_ptr<Sink> makeLineSink(FILE* out) { return make_unique<LineSink>(out); }
+
+void setSink(unique_ptr<Sink> s) { logger().setSinks(std::move(s), true); }
+void addSink(unique_ptr<Sink> s) { logger().setSinks(std::move(s), false); }
+
+void setLevel(Level l) {
+    for (auto& x : logger().levels) x.store(uint8_t(l), memory_order_relaxed);
+}
+
+void setLevel(Cat c, Level l) { logger().levels[size_t(c)].store(uint8_t(l), memory_order_relaxed); }
+
+static bool parseLevel(const string& s, Level& l) {
+    for (int i = 0; i <= int(Level::Off); ++i)
+        if (s == levelName(Level(i))) { l = Level(i); return true; }
+    return false;
+}
+
+bool configure(const string& spec) {
+    size_t b = 0;
+    while (b <= spec.size()) {
+        size_t e = spec.find(',', b);
+        if (e == string::npos) e = spec.size();
+        string item = spec.substr(b, e - b);
+        b = e + 1;
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        Level l;
+        if (eq == string::npos) {
+            if (!parseLevel(item, l)) return false;
+            setLevel(l);
+            continue;
+        }
+        string cat = item.substr(0, eq);
+        if (!parseLevel(item.substr(eq + 1), l)) return false;
+        int c = 0;
+        while (c < int(Cat::Count) && cat != catName(Cat(c))) ++c;
+        if (c == int(Cat::Count)) return false;
+        setLevel(Cat(c), l);
+    }
+    return true;
+}
+
+void flush() { logger().flush(); }
+uint64_t dropped() { return logger().lost.load(memory_order_relaxed); }
+
+bool enabled(Level l, Cat c) {
+    return uint8_t(l) >= logger().levels[size_t(c)].load(memory_order_relaxed);
+}
+
+namespace detail {
+
+Record* claim(size_t& pos) { return logger().claim(pos); }
+void publish(size_t pos) { logger().publish(pos); }
+
+uint64_t now() {
+    return uint64_t(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace detail
+
+void packet(Level l, const char* tag, const SlowPacketView& p) {
+    size_t pos;
+    Record* r = detail::claim(pos);
+    if (!r) return;
+    r->ns = detail::now();
+    r->fmt = tag;
+    r->level = l;
+    r->cat = Cat::Packet;
+    r->packet = true;
+    r->nargs = 0;
+    PacketHdr& h = r->hdr;
+    copy_n(p.sid.data(), min<size_t>(p.sid.size(), UUID_SIZE), h.sid);
+    h.sttl = p.sttl;
+    h.seqnum = p.seqnum;
+    h.acknum = p.acknum;
+    h.window = p.window;
+    h.flags = uint8_t(p.flags);
+    h.fid = p.fid;
+    h.fo = p.fo;
+    h.dataLen = uint16_t(p.data.size());
+    r->textLen = uint8_t(min<size_t>(50, p.data.size()));
+    copy_n(p.data.data(), r->textLen, r->text);
+    detail::publish(pos);
+}
+
+} // namespace slowlog
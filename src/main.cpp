@@ -1,8 +1,17 @@
+#include "bulk_transfer.h"
+#include "log.h"
+#include "metrics.h"
 #include "network.h"
+#include "sender.h"
 #include "session_manager.h"
 #include "packet.h"
 #include "slow.h"
 #include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -24,69 +33,14 @@
  */
 using namespace std;
 
-constexpr auto TL = u8"\u2554", TR = u8"\u2557";
-constexpr auto BL = u8"\u255A", BR = u8"\u255D";
-constexpr auto HL = u8"\u2550", VL = u8"\u2551";
-
-/**
- * @brief Imprime uma linha horizontal com borda e título.
- */
-inline void hLine(const char* l, const char* r, int w, const string& t = "") {
-    cout << l;
-    if (!t.empty()) cout << ' ' << t << ' ';
-    int fill = w - 2 - (t.empty() ? 0 : int(t.size()) + 2);
-    while (fill-- > 0) cout << HL;
-    cout << r << '\n';
-}
-
-/**
- * @brief Imprime uma linha vertical com conteúdo centralizado.
- */
-inline void vLine(const string& body, int w) {
-    cout << VL << ' ' << body;
-    int pad = w - 3 - int(body.size());
-    while (pad-- > 0) cout << ' ';
-    cout << VL << '\n';
-}
-
-/**
- * @brief Mostra as informações de um pacote em formato de "caixa".
- */
-inline void printPktBox(const string& tag, const SlowPacket& p) {
-    ios old(nullptr); old.copyfmt(cout);
-    vector<string> rows; stringstream ss;
-
-    ss << "SID  : ";
-    for (uint8_t b : p.sid) ss << hex << setw(2) << setfill('0') << int(b);
-    rows.push_back(ss.str()); ss.str(""); ss.clear(); ss.copyfmt(old);
-
-    ss << "FLG  : " << flagsToString(p.flags) << "  STTL: " << p.sttl;
-    rows.push_back(ss.str()); ss.str(""); ss.clear();
-
-    ss << "SEQ  : " << p.seqnum << "   ACK : " << p.acknum;
-    rows.push_back(ss.str()); ss.str(""); ss.clear();
-
-    ss << "WIN  : " << p.window << "   FID/FO: " << int(p.fid) << '/' << int(p.fo);
-    rows.push_back(ss.str());
-
-    int w = 0;
-    for (auto& r : rows) w = max(w, int(r.size()));
-    w += 3;
-
-    hLine(TL, TR, w, tag);
-    for (auto& r : rows) vLine(r, w);
-    hLine(BL, BR, w);
-    cout << '\n';
-    cout.copyfmt(old);
-}
-
 /**
  * @brief Exibe o menu principal de comandos disponíveis.
  */
 inline void banner() {
+    slowlog::flush();   // o log é assíncrono: termina de escrever antes do prompt
     cout << "\n================= S L O W   C L I E N T =================\n"
             "  d) data     x) disconnect     r) revive     ? ) status\n"
-            "  h) help     q) quit\n"
+            "  c) congest  f) file           h) help       q) quit\n"
             "=========================================================\n> ";
 }
 
@@ -95,19 +49,44 @@ inline void banner() {
  */
 inline void help() {
     cout << "\nd) enviar mensagem   x) disconnect   r) revive\n"
-            "?) status            h) ajuda        q) sair\n";
+            "?) status            h) ajuda        q) sair\n"
+            "f <arquivo>) envia um arquivo (mmap)\n"
+            "c <reno|cubic>) troca o controle de congestionamento\n";
 }
 
+static metrics::Snapshot statusBase; // Métricas no `?` anterior (ou na partida)
+
 /**
- * @brief Imprime o status atual da sessão e conexão.
+ * @brief Imprime o status atual da sessão e conexão, com as métricas do
+ *        processo; as taxas são desde o `?` anterior.
  */
-static void showStatus(const Session& s, bool conn, const char* host, int port) {
+static void showStatus(const Session& s, const Network& net, bool conn, const sockaddr_in& srv) {
+    using metrics::Counter;
+    const metrics::Snapshot& prev = statusBase;
+    metrics::Snapshot m = metrics::snapshot();
+    double secs = max<uint64_t>(1, m.ms - prev.ms) / 1e3;
+    auto rate = [&](Counter c) { return uint64_t(double(m[c] - prev[c]) / secs); };
+
+    const RttStats& r = net.rttStats();
     ostringstream ss;
-    ss << "Servidor : " << host << ':' << port << '\n'
+    ss << "Servidor : " << inet_ntoa(srv.sin_addr) << ':' << ntohs(srv.sin_port) << '\n'
        << "Conexão  : " << (conn ? "[CONECTADO]" : "[DESCONECTADO]") << '\n'
        << "Janela   : " << s.remoteWindow << " B\n"
        << "Em voo   : " << s.bytesInFlight << " B\n"
-       << "SEQ/ACK  : " << s.seqnum << " / " << s.acknum;
+       << "SEQ/ACK  : " << s.seqnum << " / " << s.acknum << '\n'
+       << fixed << setprecision(1)
+       << "SRTT/VAR : " << r.srtt << " / " << r.rttvar << " ms"
+       << (r.valid ? "" : " (sem amostras)") << '\n'
+       << "RTO      : " << r.rto << " ms\n"
+       << "CC       : " << net.congestion().name()
+       << " cwnd=" << net.congestion().cwnd() << " B\n"
+       << "Pacotes  : tx " << m[Counter::TxPackets] << " / rx " << m[Counter::RxPackets]
+       << " (retx " << m[Counter::Retransmits] << ", fast " << m[Counter::FastRetransmits]
+       << ", descartados " << m[Counter::Drops] << ")\n"
+       << "Vazão    : tx " << rate(Counter::TxBytes) << " B/s / rx " << rate(Counter::RxBytes) << " B/s\n"
+       << "Stalls   : janela " << m[Counter::WindowStalls] << ", buffer " << m[Counter::BufferStalls] << '\n'
+       << "RTT      : n=" << m.rtt.count() << " p50 " << m.rtt.percentile(0.5)
+       << " p99 " << m.rtt.percentile(0.99) << " max " << m.rtt.max() << " ms";
     string l; size_t w = 0; vector<string> rows;
     istringstream is(ss.str());
     while (getline(is, l)) { rows.push_back(l); w = max(w, l.size()); }
@@ -116,44 +95,179 @@ static void showStatus(const Session& s, bool conn, const char* host, int port)
     cout << "┌" << bord << "┐\n";
     for (auto& r : rows) cout << "│  " << left << setw(w) << r << "  │\n";
     cout << "└" << bord << "┘\n\n";
+    statusBase = std::move(m);
+}
+
+/**
+ * @brief Uma linha de progresso de um BulkTransfer.
+ */
+static void showProgress(const BulkTransfer::Progress& p) {
+    ios old(nullptr); old.copyfmt(cout);
+    cout << fixed << setprecision(1) << "[bulk] " << p.acked / 1e6;
+    if (p.total) cout << " / " << p.total / 1e6 << " MB (" << 100.0 * p.acked / p.total << "%)";
+    else cout << " MB";
+    cout << "  " << p.messages << " msg  " << setprecision(2) << p.mbps() << " MB/s\n";
+    cout.copyfmt(old);
 }
 
 /**
- * @brief Envia um pacote ACK puro para manter a sessão ativa ou atualizar janela.
+ * @brief Envia um arquivo (comando f e opção -f) e mostra a vazão.
  */
-static void sendPureAck(Network& net, const sockaddr_in& srv, Session& s) {
-    SlowPacket a;
-    a.sid = s.sid;
-    a.flags = ACK;
-    a.seqnum = s.seqnum;
-    a.acknum = s.acknum;
-    a.window = s.recvWindow;
-    a.sttl = s.sttl;
-    uint32_t dummy;
-    net.sendPacket(srv, a, dummy, s);
+static bool sendFile(Network& net, const sockaddr_in& srv, Session& sess, const string& path) {
+    BulkTransfer bulk(net, srv, sess);
+    bulk.onProgress(showProgress);
+    bool ok = bulk.sendFile(path.c_str());
+    slowlog::flush();
+    if (!ok) {
+        cout << "[erro] Arquivo não confirmado\n";
+        return false;
+    }
+    const BulkTransfer::Progress& p = bulk.progress();
+    ios old(nullptr); old.copyfmt(cout);
+    cout << fixed << setprecision(2) << "[sucesso] Arquivo enviado (" << p.acked << " B em "
+         << p.elapsedMs / 1e3 << " s, " << p.mbps() << " MB/s)\n";
+    cout.copyfmt(old);
+    return true;
 }
 
-int main() {
-    const char* HOST = "142.93.184.175";
-    const int PORT = SLOW_PORT;
+/**
+ * @brief Lê o próximo comando; enquanto o usuário não digita, mantém a
+ *        sessão viva com keep-alives antes do STTL vencer.
+ *
+ * Só com terminal: com entrada redirecionada o buffer do stdio esconde
+ * linhas do poll, e a leitura volta a ser um getline simples.
+ */
+static bool readCommand(string& line, Network& net, sockaddr_in& srv, Session& sess, bool& connected) {
+    static const bool tty = isatty(STDIN_FILENO);
+    uint64_t retryAt = 0;
+    while (tty && connected) {
+        uint64_t due = max(keepAliveDue(net, sess), retryAt), now = nowMs();
+        if (due == TimerWheel::NONE) break;
+        pollfd p{STDIN_FILENO, POLLIN, 0};
+        if (poll(&p, 1, due > now ? int(min<uint64_t>(due - now, INT_MAX)) : 0) != 0) break;
+
+        uint64_t heard = net.lastHeard();
+        if (!keepAlive(net, srv, sess)) {
+            connected = false;
+            net.resetFlight(sess);
+            slowlog::flush();
+            cout << "\n[keepalive] sessão perdida (use r)\n> " << flush;
+        } else if (net.lastHeard() == heard) retryAt = nowMs() + sess.sttl / 8; // resposta perdida
+        slowlog::flush();
+    }
+    return bool(getline(cin, line));
+}
 
-    Network net;
-    if (!net.createSocket()) { cerr << "socket() erro\n"; return 1; }
+int main(int argc, char** argv) {
+    string host = "142.93.184.175"; // servidor público; --host=ip[:porta] troca (ex.: slow_server local)
+
+    bool offload = false;
+    string backend = "socket";
+    string file; // -f: envia o arquivo e sai, sem o menu
+    Capture cap; // --capture: datagramas em pcap (ver slow_replay)
+    ImpairedTransport::Config imp; // --impair: perda/atraso simulados
+    bool impaired = false;
+    string cachePath; // --session-cache: retoma a sessão do processo anterior
+    metrics::Exporter::Config mcfg; // --metrics-file / --metrics-socket
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--gso") offload = true;
+        else if (a.rfind("--host=", 0) == 0) host = a.substr(7);
+        else if (a.rfind("--backend=", 0) == 0) backend = a.substr(10);
+        else if (a == "-f" && i + 1 < argc) file = argv[++i];
+        else if (a.rfind("--log=", 0) == 0 && slowlog::configure(a.substr(6))) {}
+        else if (a.rfind("--log-file=", 0) == 0) {
+            FILE* f = fopen(a.c_str() + 11, "a");
+            if (!f) { cerr << "[log] " << a.substr(11) << ": " << strerror(errno) << '\n'; return 1; }
+            slowlog::setSink(slowlog::makeLineSink(f));
+        }
+        else if (a.rfind("--capture=", 0) == 0) {
+            if (!cap.open(a.c_str() + 10)) return 1;
+        }
+        else if (a.rfind("--impair=", 0) == 0 && parseImpairment(a.substr(9), imp)) impaired = true;
+        else if (a.rfind("--session-cache=", 0) == 0) cachePath = a.substr(16);
+        else if (a.rfind("--metrics-file=", 0) == 0) mcfg.file = a.substr(15);
+        else if (a.rfind("--metrics-socket=", 0) == 0) mcfg.socket = a.substr(17);
+        else {
+            cerr << "uso: " << argv[0] << " [--host=ip[:porta]] [--gso] [--backend=socket|uring] [-f arquivo]\n"
+                    "       [--log=nível,categoria=nível,...] [--log-file=arquivo] [--capture=arquivo.pcap]\n"
+                    "       [--session-cache=arquivo] [--metrics-file=arquivo] [--metrics-socket=caminho]\n"
+                    "       [--impair=loss=0.02,burst=3,delay=20,jitter=5,reorder=0.01,dup=0.005,rate=10m,seed=N]\n";
+            return 1;
+        }
+    }
 
-    sockaddr_in srv{}; srv.sin_family = AF_INET;
-    srv.sin_port = htons(PORT);
-    inet_pton(AF_INET, HOST, &srv.sin_addr);
+    metrics::Exporter exporter;
+    if ((!mcfg.file.empty() || !mcfg.socket.empty()) && !exporter.start(mcfg)) return 1;
+    statusBase = metrics::snapshot();
 
-    Session sess; sess.recvWindow = 7200;
+    Network net;
+    if (!net.createSocket(backend)) {
+        cerr << "[io] backend '" << backend << "' indisponível neste build/kernel, usando socket\n";
+        if (!net.createSocket()) { cerr << "socket() erro\n"; return 1; }
+    }
+    if (impaired) net.impair(imp);
+    if (cap.isOpen()) net.setCapture(&cap);
+    if (offload && !net.enableOffload()) cerr << "[gso] UDP_SEGMENT indisponível, usando envio normal\n";
+
+    sockaddr_in srv;
+    if (!parseAddress(host, srv, SLOW_PORT)) { cerr << "[erro] endereço inválido: " << host << '\n'; return 1; }
+
+    // dados enviados pelo servidor são remontados e exibidos inteiros;
+    // a janela anunciada continua limitada aos 7200 B de sempre
+    Reassembler rx(Reassembler::DEFAULT_SLOTS, 7200);
+    rx.onMessage([](ByteSpan, uint8_t fid, ByteSpan msg) {
+        size_t show = min<size_t>(50, msg.size());
+        cout << "[RX] mensagem completa (" << msg.size() << " B, FID " << int(fid) << "): \""
+             << string(msg.begin(), msg.begin() + show) << (msg.size() > show ? "…" : "") << "\"\n";
+    });
+    net.setReassembler(&rx);
+
+    Session sess; sess.recvWindow = rx.window();
     bool connected = false;
+    bool ok = false;
+
+    /* retoma a sessão gravada por um processo anterior, se o servidor aceitar */
+    SessionCache cache;
+    if (!cachePath.empty() && cache.open(cachePath.c_str(), srv)) {
+        if (cache.load(sess)) {
+            ok = tryRevive(net, srv, sess);
+            slowlog::flush();
+            if (ok) cout << "[sucesso] Sessão retomada do cache (revive).\n";
+            else {
+                cout << "[cache] revive recusado, refazendo o handshake\n";
+                cache.invalidate();
+                net.resetFlight(sess);
+                sess = Session();
+                sess.recvWindow = rx.window();
+            }
+        }
+        net.setSessionCache(&cache);
+    }
 
      /* faz o 3-way handshake inicial */
-    if (!doThreeWayHandshake(net, srv, sess)) return 1;
-    connected = true; cout << "[sucesso] Conectado.\n";
+    if (!ok) {
+        ok = doThreeWayHandshake(net, srv, sess);
+        slowlog::flush();
+        if (!ok) return 1;
+        cout << "[sucesso] Conectado.\n";
+    }
+    connected = true;
+
+    if (!file.empty()) {
+        ok = sendFile(net, srv, sess, file);
+        uint32_t last; net.sendPacket(srv, makeDisconnect(sess), last, sess);
+        SlowPacket resp; sockaddr_in from{};
+        bool acked = net.receivePacket(resp, from, sess) && (resp.flags & ACK);
+        slowlog::flush();
+        if (acked) cout << "[sucesso] Desconectado.\n";
+        net.closeSocket();
+        return ok ? 0 : 1;
+    }
 
     while (true) {
         banner();
-        string line; if (!getline(cin, line)) break;
+        string line; if (!readCommand(line, net, srv, sess, connected)) break;
         auto trim = [&](string& s) {
             auto b = s.find_first_not_of(" \t\r\n");
             auto e = s.find_last_not_of(" \t\r\n");
@@ -170,78 +284,48 @@ int main() {
             string msg; getline(cin, msg);
             if (msg.empty()) continue;
 
-            bool willFrag = msg.size() > MAX_DATA;
-            uint8_t fid = willFrag ? Session::generateUUID()[0] : 0;
-            uint8_t fo = 0;
-            size_t off = 0;
-
+            Sender tx(net, srv, sess);
+            bool willFrag = msg.size() > tx.segment();
             cout << (willFrag ? "Mensagem será fragmentada (" : "Enviando mensagem sem fragmentar (")
                  << msg.size() << " bytes): \"" << msg.substr(0, 50)
                  << (msg.size() > 50 ? "…" : "") << "\"\n";
 
-            while (off < msg.size()) {
-                size_t freeWin = sess.remoteWindow - sess.bytesInFlight;
-                if (!freeWin) {
-                    sendPureAck(net, srv, sess);
-                    SlowPacket ack; sockaddr_in f{};
-                    if (net.receivePacket(ack, f, sess) && (ack.flags & ACK)) {
-                        sess.remoteWindow = ack.window;
-                        sess.bytesInFlight = 0;
-                        sess.acknum = ack.seqnum;
-                        cout << "[debug] Janela atualizada: " << ack.window << '\n';
-                    }
-                    continue;
-                }
-
-                size_t chunk = min<size_t>({MAX_DATA, msg.size() - off, freeWin});
-                /* Monta pacote de dados (pode ser fragmento) */
-                SlowPacket p;
-                p.sid = sess.sid;
-                p.flags = ACK | ((off + chunk < msg.size()) ? MOREBITS : 0);
-                p.seqnum = ++sess.seqnum;
-                p.acknum = sess.acknum;
-                p.window = sess.recvWindow;
-                p.sttl = sess.sttl;
-                p.fid = willFrag ? fid : 0;
-                p.fo = willFrag ? fo++ : 0;
-                p.data.assign(msg.begin() + off, msg.begin() + off + chunk);
-
-                uint32_t lastSeq;
-                net.sendPacket(srv, p, lastSeq, sess);
-                sess.bytesInFlight += chunk;
-                off += chunk;
-
-                /* Aguarda ACK correspondente */
-                SlowPacket a; sockaddr_in from{};
-                while (net.receivePacket(a, from, sess)) {
-                    if ((a.flags & ACK) && a.acknum == lastSeq) {
-                        sess.remoteWindow = a.window;
-                        sess.bytesInFlight = 0;
-                        sess.acknum = a.seqnum;
-                        cout << "✓ ACK " << a.acknum << " (" << chunk << " B)\n";
-                        cout << "[debug] Janela atualizada: " << a.window << '\n';
-                        break;
-                    }
-                }
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(msg.data());
+            if (msg.size() <= tx.maxMessage()) ok = tx.send(bytes, msg.size());
+            else {
+                // o FO daria a volta: segue como várias mensagens (FIDs)
+                cout << "Acima de " << tx.maxMessage() << " B: enviando em várias mensagens\n";
+                BulkTransfer bulk(net, srv, sess);
+                bulk.onProgress(showProgress);
+                ok = bulk.send(bytes, msg.size());
+            }
+            slowlog::flush();
+            if (!ok) {
+                cout << "[erro] Mensagem não confirmada\n";
+                continue;
             }
             cout << "[sucesso] Mensagem enviada (" << msg.size() << " B)\n";
         }
 
+        /*────────────────── enviar arquivo ──────────────────*/
+        else if (cmd == 'f') {
+            if (!connected) { cout << "[erro] sem sessão (use r)\n"; continue; }
+            string path = line.substr(1); trim(path);
+            if (path.empty()) { cout << "[erro] uso: f <arquivo>\n"; continue; }
+            sendFile(net, srv, sess, path);
+        }
+
         /*────────────────── disconnect ──────────────────*/
         else if (cmd == 'x') {
             if (!connected) { cout << "[já desconectado]\n"; continue; }
 
-            SlowPacket disc;
-            disc.sid = sess.sid;
-            disc.flags = CONNECT | REVIVE | ACK;
-            disc.seqnum = ++sess.seqnum;
-            disc.acknum = sess.acknum;
-
-            uint32_t last; net.sendPacket(srv, disc, last, sess);
+            uint32_t last; net.sendPacket(srv, makeDisconnect(sess), last, sess);
 
             SlowPacket resp; sockaddr_in from{};
-            if (net.receivePacket(resp, from, sess) && (resp.flags & ACK)) {
-                connected = false; sess.bytesInFlight = 0;
+            bool acked = net.receivePacket(resp, from, sess) && (resp.flags & ACK);
+            slowlog::flush();
+            if (acked) {
+                connected = false; net.resetFlight(sess);
                 cout << "[sucesso] Desconectado.\n";
             } else cout << "[erro] sem ACK do disconnect.\n";
         }
@@ -255,28 +339,31 @@ int main() {
             if (payload.empty()) payload = "revive";
             cout << '\n';
 
-            SlowPacket r;
-            r.sid = sess.sid;
-            r.flags = REVIVE | ACK;
-            r.seqnum = ++sess.seqnum;
-            r.acknum = sess.acknum;
-            r.window = sess.recvWindow;
-            r.sttl = sess.sttl;
-            r.data.assign(payload.begin(), payload.end());
-
             uint32_t lastSeq;
-            net.sendPacket(srv, r, lastSeq, sess);
+            net.sendPacket(srv, makeRevive(sess, payload), lastSeq, sess);
 
             SlowPacket resp; sockaddr_in from{};
-            if (net.receivePacket(resp, from, sess) && (resp.flags & (ACK | ACCEPT))) {
+            bool accepted = net.receivePacket(resp, from, sess) && (resp.flags & (ACK | ACCEPT));
+            slowlog::flush();
+            if (accepted) {
                 sess.acknum = resp.seqnum;
                 sess.remoteWindow = resp.window;
-                sess.bytesInFlight = 0;
+                net.resetFlight(sess);
+                metrics::add(metrics::Counter::Revives);
                 connected = true; cout << "[revive OK]\n";
             } else cout << "[revive rejeitado]\n";
         }
+        /*────────────────── congestionamento ──────────────────*/
+        else if (cmd == 'c') {
+            string algo = line.substr(1); trim(algo);
+            if (algo.empty()) { cout << "[cc] " << net.congestion().name() << '\n'; continue; }
+            auto cc = makeCongestionController(algo);
+            if (!cc) { cout << "[erro] algoritmo desconhecido: " << algo << '\n'; continue; }
+            net.setCongestionControl(move(cc));
+            cout << "[cc] usando " << net.congestion().name() << '\n';
+        }
         /*────────────────── status ──────────────────*/
-        else if (cmd == '?') showStatus(sess, connected, HOST, PORT);
+        else if (cmd == '?') showStatus(sess, net, connected, srv);
         /*────────────────── ajuda ──────────────────*/
         else if (cmd == 'h') help();
         /*────────────────── quit ──────────────────*/
@@ -0,0 +1,224 @@
+#include "metrics.h"
+#include "log.h"
+#include "network.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @file    metrics.cpp
+ * @brief   Lista de shards, snapshot, formato Prometheus e exportador.
+ *
+ * A lista de shards só cresce, por push com CAS na cabeça: quem lê
+ * percorre uma lista que nunca perde nós. A thread do exportador só lê
+ * os shards, nunca escreve neles.
+ */
+
+namespace metrics {
+
+namespace {
+
+atomic<Shard*> head{nullptr};
+
+constexpr uint64_t POLL_SLICE_MS = 200; // Resposta a stop() sem self-pipe
+constexpr uint64_t REQUEST_WAIT_MS = 100; // Espera pelo pedido de quem conectou
+
+struct Info {
+    const char* name;
+    const char* help;
+};
+
+constexpr Info COUNTER_INFO[COUNTERS] = {
+    {"slow_tx_packets_total", "Datagramas enviados (inclui retransmissões)."},
+    {"slow_tx_bytes_total", "Bytes enviados, cabeçalho incluído."},
+    {"slow_rx_packets_total", "Datagramas SLOW válidos recebidos."},
+    {"slow_rx_bytes_total", "Bytes recebidos, cabeçalho incluído."},
+    {"slow_retransmits_total", "Retransmissões por RTO."},
+    {"slow_fast_retransmits_total", "Retransmissões rápidas por ACKs duplicados."},
+    {"slow_drops_total", "Pacotes descartados após MAX_TRIES tentativas."},
+    {"slow_window_stalls_total", "Envios adiados por janela (ou cwnd) cheia."},
+    {"slow_buffer_stalls_total", "Envios adiados por falta de slot no pool."},
+    {"slow_handshakes_total", "3-way handshakes concluídos."},
+    {"slow_revives_total", "Revives aceitos pelo servidor."},
+    {"slow_keepalives_total", "Keep-alives enviados a sessões ociosas."},
+    {"slow_window_probes_total", "Probes do persist timer (janela zero)."},
+    {"slow_piggybacked_acks_total", "ACKs levados por pacotes com dados, sem pure-ACK."},
+};
+
+constexpr Info GAUGE_INFO[GAUGES] = {
+    {"slow_bytes_in_flight", "Bytes enviados ainda sem ACK."},
+    {"slow_pending_packets", "Pacotes na fila de retransmissão."},
+    {"slow_cwnd_bytes", "Janela de congestionamento, somada entre as sessões."},
+};
+
+bool writeAll(int fd, const char* p, size_t n) {
+    while (n) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= size_t(w);
+    }
+    return true;
+}
+
+} // namespace
+
+namespace detail {
+
+Shard* attach() {
+    Shard* s = new Shard();
+    s->next = head.load(memory_order_relaxed);
+    while (!head.compare_exchange_weak(s->next, s, memory_order_release, memory_order_relaxed)) {}
+    return s;
+}
+
+} // namespace detail
+
+const char* name(Counter c) { return COUNTER_INFO[size_t(c)].name; }
+const char* name(Gauge g) { return GAUGE_INFO[size_t(g)].name; }
+
+Snapshot snapshot() {
+    Snapshot snap;
+    snap.ms = nowMs();
+    for (Shard* s = head.load(memory_order_acquire); s; s = s->next) {
+        for (size_t i = 0; i < COUNTERS; ++i) snap.counters[i] += s->counters[i].load(memory_order_relaxed);
+        for (size_t i = 0; i < GAUGES; ++i) snap.gauges[i] += s->gauges[i].load(memory_order_relaxed);
+        for (size_t b = 0; b < Histogram::BUCKETS; ++b) {
+            uint64_t n = s->rtt[b].load(memory_order_relaxed);
+            if (!n) continue;
+            uint64_t v = Histogram::lowerBound(b);
+            snap.rtt.record(v, n);
+            for (size_t k = 0; k < Snapshot::RTT_BUCKETS; ++k)
+                if (double(v) <= Snapshot::RTT_LE[k] * 1000) snap.rttLe[k] += n;
+        }
+        snap.rttSumMs += s->rttSum.load(memory_order_relaxed);
+    }
+    snap.logDropped = slowlog::dropped();
+    return snap;
+}
+
+string render(const Snapshot& s) {
+    string out;
+    char line[160];
+    auto emit = [&](const char* fmt, auto... a) {
+        snprintf(line, sizeof line, fmt, a...);
+        out += line;
+    };
+    for (size_t i = 0; i < COUNTERS; ++i) {
+        const Info& m = COUNTER_INFO[i];
+        emit("# HELP %s %s\n# TYPE %s counter\n%s %" PRIu64 "\n", m.name, m.help, m.name, m.name, s.counters[i]);
+    }
+    for (size_t i = 0; i < GAUGES; ++i) {
+        const Info& m = GAUGE_INFO[i];
+        emit("# HELP %s %s\n# TYPE %s gauge\n%s %" PRId64 "\n", m.name, m.help, m.name, m.name, s.gauges[i]);
+    }
+    out += "# HELP slow_rtt_seconds Amostras de RTT (regra de Karn).\n# TYPE slow_rtt_seconds histogram\n";
+    for (size_t k = 0; k < Snapshot::RTT_BUCKETS; ++k)
+        emit("slow_rtt_seconds_bucket{le=\"%g\"} %" PRIu64 "\n", Snapshot::RTT_LE[k], s.rttLe[k]);
+    emit("slow_rtt_seconds_bucket{le=\"+Inf\"} %" PRIu64 "\n", s.rtt.count());
+    emit("slow_rtt_seconds_sum %.3f\n", double(s.rttSumMs) / 1000);
+    emit("slow_rtt_seconds_count %" PRIu64 "\n", s.rtt.count());
+    emit("# HELP slow_log_dropped_total Registros de log perdidos por fila cheia.\n"
+         "# TYPE slow_log_dropped_total counter\nslow_log_dropped_total %" PRIu64 "\n", s.logDropped);
+    return out;
+}
+
+bool Exporter::start(const Config& c) {
+    stop();
+    cfg = c;
+    if (!cfg.socket.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (cfg.socket.size() >= sizeof addr.sun_path) {
+            SLOW_LOG(Error, Io, "[metrics] caminho longo demais: {}", cfg.socket);
+            return false;
+        }
+        memcpy(addr.sun_path, cfg.socket.c_str(), cfg.socket.size());
+        ::unlink(cfg.socket.c_str()); // sobra de uma execução anterior
+        lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (lfd < 0 || bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || listen(lfd, 8) < 0) {
+            SLOW_LOG(Error, Io, "[metrics] socket {}: {}", cfg.socket, strerror(errno));
+            stop();
+            return false;
+        }
+    }
+    running = true;
+    worker = thread([this] { run(); });
+    return true;
+}
+
+void Exporter::stop() {
+    running = false;
+    if (worker.joinable()) worker.join();
+    if (lfd >= 0) {
+        ::close(lfd);
+        ::unlink(cfg.socket.c_str());
+        lfd = -1;
+    }
+}
+
+/**
+ * @brief Grava em `arquivo.tmp` e renomeia: leitores nunca veem meio arquivo.
+ */
+bool Exporter::writeFile(const string& text) {
+    string tmp = cfg.file + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, text.data(), text.size());
+    ::close(fd);
+    return ok && ::rename(tmp.c_str(), cfg.file.c_str()) == 0;
+}
+
+/**
+ * @brief Atende uma conexão: resposta HTTP/1.0 mínima com o snapshot
+ *        (serve a `curl --unix-socket` e a proxies de scrape).
+ */
+void Exporter::serveOne() {
+    int fd = accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    // consome o pedido (se vier) antes de responder; o conteúdo não importa
+    char req[1024];
+    pollfd p{fd, POLLIN, 0};
+    if (poll(&p, 1, int(REQUEST_WAIT_MS)) > 0) (void)::recv(fd, req, sizeof req, MSG_DONTWAIT);
+    string body = render(snapshot());
+    string resp = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                  to_string(body.size()) + "\r\n\r\n" + body;
+    for (size_t off = 0; off < resp.size();) {
+        ssize_t w = ::send(fd, resp.data() + off, resp.size() - off, MSG_NOSIGNAL); // sem SIGPIPE
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        off += size_t(w);
+    }
+    ::close(fd);
+}
+
+void Exporter::run() {
+    uint64_t nextWrite = nowMs();
+    bool warned = false;
+    while (running) {
+        uint64_t now = nowMs();
+        if (!cfg.file.empty() && now >= nextWrite) {
+            if (!writeFile(render(snapshot())) && !warned) {
+                SLOW_LOG(Error, Io, "[metrics] {}: {}", cfg.file, strerror(errno));
+                warned = true;
+            }
+            nextWrite = now + cfg.periodMs;
+        }
+        uint64_t wait = cfg.file.empty() ? POLL_SLICE_MS : min(POLL_SLICE_MS, nextWrite - min(nextWrite, nowMs()));
+        pollfd p{lfd, POLLIN, 0};
+        if (lfd < 0) { usleep(useconds_t(wait * 1000)); continue; }
+        if (poll(&p, 1, int(wait)) > 0) serveOne();
+    }
+    if (!cfg.file.empty()) writeFile(render(snapshot())); // valores finais
+}
+
+} // namespace metrics
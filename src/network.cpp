@@ -1,9 +1,7 @@
 #include "network.h"
+#include "log.h"
 #include <algorithm>
 #include <cstring>
-#include <iostream>
-#include <unistd.h>
-#include <sys/select.h>
 using namespace std;
 
 /**
@@ -16,116 +14,498 @@ using namespace std;
  * até serem confirmados por ACK.
  */
 
- 
+uint64_t (*nowMsHook)() = nullptr;
+
 /**
  * @brief Adiciona um pacote enviado à fila de pendentes.
+ *
+ * O cabeçalho já está no slot; o payload é copiado logo atrás dele (a
+ * única cópia) e o slot passa a pertencer ao pendente.
+ */
+void Network::pushPending(PacketRef buf, ByteSpan payload, uint32_t seq) {
+    uint64_t deadline = nowMs() + rtt.rto;
+    if (!payload.empty()) memcpy(buf.data() + HDR_SIZE, payload.data(), payload.size());
+    pend.emplace_back(std::move(buf), HDR_SIZE + payload.size(), seq, payload.size(), deadline);
+    timers.schedule(seq, deadline);
+}
+
+/**
+ * @brief Atualiza SRTT/RTTVAR com uma nova amostra e recalcula o RTO.
+ *
+ * Segue a RFC 6298: na primeira amostra SRTT = R e RTTVAR = R/2; depois
+ * RTTVAR = 3/4·RTTVAR + 1/4·|SRTT − R| e SRTT = 7/8·SRTT + 1/8·R.
  */
-void Network::pushPending(const uint8_t* buf, size_t len, uint32_t seq, size_t dsz) {
-    pend.emplace_back(buf, len, seq, dsz);
+void Network::sampleRtt(uint64_t ms) {
+    double r = double(ms);
+    if (!rtt.valid) {
+        rtt.srtt = r;
+        rtt.rttvar = r / 2;
+        rtt.valid = true;
+    } else {
+        rtt.rttvar = 0.75 * rtt.rttvar + 0.25 * (rtt.srtt > r ? rtt.srtt - r : r - rtt.srtt);
+        rtt.srtt = 0.875 * rtt.srtt + 0.125 * r;
+    }
+    ++rtt.samples;
+    backedOff = 0;
+    metrics::observeRtt(ms);
+    uint64_t rto = uint64_t(rtt.srtt + max(10.0, 4 * rtt.rttvar));
+    rtt.rto = min(MAX_RTO_MS, max(MIN_RTO_MS, rto));
+}
+
+/**
+ * @brief Dobra o RTO após um timeout, limitado a MAX_RTO_MS.
+ *
+ * Vale para todos os pacotes, inclusive os novos, até que sampleRtt o
+ * recalcule (RFC 6298 §5.5 e §5.7).
+ */
+void Network::backoff() {
+    rtt.rto = min(MAX_RTO_MS, rtt.rto * 2);
 }
 
 /**
  * @brief Remove da fila os pacotes já confirmados via ACK.
+ *
+ * O pacote que provocou o ACK (seq == ack) fornece uma amostra de RTT,
+ * exceto se tiver sido retransmitido (regra de Karn).
  */
 void Network::dropAcked(uint32_t ack, Session& sess) {
+    uint64_t now = nowMs();
+    uint32_t acked = 0;
+    if (!pend.empty() && pend.front().seq <= ack) backedOff = 0; // cumulativo avançou
     while (!pend.empty() && pend.front().seq <= ack) {
-        sess.bytesInFlight -= pend.front().dataSz;
+        const Pending& p = pend.front();
+        if (p.seq == ack && p.tries == 0) sampleRtt(now - p.sentAt);
+        sess.bytesInFlight -= p.dataSz;
+        acked += p.dataSz;
         pend.pop_front();
     }
+    // durante a recuperação a cwnd fica congelada até sair dela
+    if (acked && !inRecovery) cc->onAck(acked, now, rtt.srtt);
+    if (acked && pend.empty()) cc->onIdle(now);
 }
 
 /**
- * @brief Reenvia o primeiro pacote pendente, se necessário.
+ * @brief Processa um ACK: scoreboard, avanço cumulativo e ACKs duplicados.
  *
- * Se o tempo decorrido desde o último envio exceder RETRY_MS,
- * tenta retransmitir até MAX_TRIES. Após isso, descarta o pacote.
- *
- * @return true se houve retransmissão; false se nada foi feito.
- */
-bool Network::retransmit(const sockaddr_in& addr, Session& sess) {
-    if (pend.empty()) return false;
-    Pending& p = pend.front();
-    if (nowMs() - p.sentAt < RETRY_MS) return false;
-    if (p.tries >= MAX_TRIES) {
-        cerr << "[timeout] seq " << p.seq << " excedeu MAX_TRIES, descartando\n";
-        sess.bytesInFlight -= p.dataSz;
-        pend.pop_front();
-        return false;
+ * Um pure-ACK cujo seqnum aponta para um pendente além do acknum indica
+ * que o peer já recebeu aquele pacote fora de ordem; ele é marcado como
+ * `sacked` e nunca é reenviado por fast retransmit. Ao atingir
+ * DUPACK_THRESHOLD duplicados, apenas o primeiro buraco é reenviado e a
+ * sessão entra em recuperação até que `recover` seja confirmado; ACKs
+ * parciais nesse período reenviam imediatamente o próximo buraco.
+ */
+void Network::onAck(const SlowPacketView& pkt, Session& sess) {
+    bool pure = pkt.data.empty() && (pkt.flags & ACK);
+    if (pure && pkt.seqnum > pkt.acknum) {
+        auto it = lower_bound(pend.begin(), pend.end(), pkt.seqnum,
+                              [](const Pending& p, uint32_t s) { return p.seq < s; });
+        if (it != pend.end() && it->seq == pkt.seqnum) it->sacked = true;
+    }
+
+    bool dup = pure && pkt.acknum == lastAck && !pend.empty() && pend.front().seq > pkt.acknum;
+    dropAcked(pkt.acknum, sess);
+    sess.remoteWindow = pkt.window;
+    flow.opened(pkt.window);
+
+    if (dup) {
+        if (++dupAcks == DUPACK_THRESHOLD && !inRecovery) {
+            inRecovery = true;
+            recover = pend.back().seq;
+            cc->onLoss(nowMs());
+            if (!pend.front().sacked) fastRetransmit(pend.front());
+        } else if (inRecovery && dupAcks > DUPACK_THRESHOLD) {
+            // buraco seguinte: não confirmado, ainda não reenviado e com algo
+            // já recebido pelo peer depois dele
+            auto lastSacked = find_if(pend.rbegin(), pend.rend(), [](const Pending& p) { return p.sacked; });
+            for (auto it = pend.begin(); lastSacked != pend.rend() && it != lastSacked.base() - 1; ++it)
+                if (!it->sacked && !it->fastRetx) { fastRetransmit(*it); break; }
+        }
+        return;
     }
+    if (pkt.acknum == lastAck) return;
+
+    lastAck = pkt.acknum;
+    dupAcks = 0;
+    if (!inRecovery) return;
+    if (pend.empty() || pkt.acknum >= recover) {
+        inRecovery = false;
+        for (auto& p : pend) p.fastRetx = false;
+    } else if (!pend.front().sacked && !pend.front().fastRetx) {
+        fastRetransmit(pend.front());   // ACK parcial
+    }
+}
+
+/**
+ * @brief Reenvia um pendente e reagenda seu deadline.
+ */
+void Network::resend(Pending& p, uint64_t now, uint64_t timeout) {
     ++p.tries;
-    p.sentAt = nowMs();
-    ::sendto(sockfd, p.buf.data(), p.buf.size(), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
-    cout << "↻ RETX seq=" << p.seq << " (try " << p.tries << '/' << MAX_TRIES << ")\n";
-    return true;
+    p.sentAt = now;
+    p.deadline = now + timeout;
+    timers.schedule(p.seq, p.deadline);
+    OutDatagram d;
+    d.iov[0] = {p.buf.data(), p.len};
+    if (io->send(peer, &d, 1) != 1) return;
+    metrics::add(metrics::Counter::TxPackets);
+    metrics::add(metrics::Counter::TxBytes, p.len);
+    if (cap) cap->record(Capture::Tx, peer, d);
 }
 
-Network::Network() = default;
-Network::~Network() { closeSocket(); }
+/**
+ * @brief Reenvia um buraco sem esperar o RTO (não aplica backoff).
+ */
+void Network::fastRetransmit(Pending& p) {
+    p.fastRetx = true;
+    metrics::add(metrics::Counter::FastRetransmits);
+    resend(p, nowMs(), rtt.rto);
+    SLOW_LOG(Info, Retx, "⚡ FAST RETX seq={} (dupacks {})", p.seq, dupAcks);
+}
+
+void Network::resetFlight(Session& sess) {
+    pend.clear();
+    timers.clear();
+    inRecovery = false;
+    dupAcks = 0;
+    backedOff = 0;
+    sess.bytesInFlight = 0;
+    flow.reset();
+    publishGauges(sess);
+}
+
+/**
+ * @brief Publica nos gauges a variação desde a última publicação.
+ */
+void Network::publishGauges(const Session& sess) {
+    int64_t now[metrics::GAUGES] = {int64_t(sess.bytesInFlight), int64_t(pend.size()), int64_t(cc->cwnd())};
+    for (size_t i = 0; i < metrics::GAUGES; ++i) {
+        metrics::add(metrics::Gauge(i), now[i] - shown[i]);
+        shown[i] = now[i];
+    }
+}
+
+/**
+ * @brief Reenvia todos os pacotes pendentes cujo deadline venceu.
+ *
+ * A roda de temporizadores devolve os seqnums vencidos; entradas que
+ * já foram confirmadas (ou reagendadas) são ignoradas. Cada pacote é
+ * tentado até MAX_TRIES vezes e depois descartado.
+ *
+ * Os pacotes de uma mesma janela vencem em chamadas diferentes, então
+ * o RTO só dobra quando a tentativa do pacote que venceu passa da maior
+ * já aplicada (`backedOff`), e o onTimeout do controlador só roda no
+ * primeiro timeout do episódio (RFC 5681: ssthresh não cai de novo a
+ * cada reenvio do mesmo segmento). Nova amostra de RTT ou avanço do ACK
+ * cumulativo encerram o episódio.
+ *
+ * @return quantidade de pacotes retransmitidos.
+ */
+int Network::retransmit(Session& sess) {
+    uint64_t now = nowMs();
+    expired.clear();
+    timers.expire(now, expired);
+    int sent = 0;
+    bool timeout = false;
+    for (uint32_t seq : expired) {
+        auto it = lower_bound(pend.begin(), pend.end(), seq,
+                              [](const Pending& p, uint32_t s) { return p.seq < s; });
+        if (it == pend.end() || it->seq != seq || it->deadline > now) continue;
+        if (it->tries >= MAX_TRIES) {
+            SLOW_LOG(Warn, Retx, "[timeout] seq {} excedeu MAX_TRIES, descartando", seq);
+            metrics::add(metrics::Counter::Drops);
+            sess.bytesInFlight -= it->dataSz;
+            dropped += it->dataSz;
+            pend.erase(it);
+            continue;
+        }
+        if (it->sacked) {
+            // o peer já tem o pacote: adia uma vez em vez de reenviar, mas
+            // desconfia da marca caso o cumulativo não avance
+            it->sacked = false;
+            it->deadline = now + rtt.rto;
+            timers.schedule(seq, it->deadline);
+            continue;
+        }
+        if (it->tries >= backedOff) {
+            timeout |= !backedOff;
+            backoff();
+            backedOff = it->tries + 1;
+        }
+        resend(*it, now, rtt.rto);
+        SLOW_LOG(Info, Retx, "↻ RETX seq={} (try {}/{})", seq, it->tries, MAX_TRIES);
+        ++sent;
+    }
+    // uma única redução por episódio de RTO
+    if (timeout) cc->onTimeout(now);
+    metrics::add(metrics::Counter::Retransmits, uint64_t(sent));
+    if (!expired.empty()) publishGauges(sess);
+    return sent;
+}
+
+/**
+ * @brief Retransmissões, probe de janela zero e ACK atrasado vencidos.
+ */
+int Network::service(Session& sess) {
+    int sent = retransmit(sess);
+    uint64_t now = nowMs();
+    if (flow.probeDue(now)) {
+        SLOW_LOG(Debug, Flow, "[FLOW] janela zero, probe");
+        metrics::add(metrics::Counter::WindowProbes);
+        sendPureAck(probeTo, sess);
+    }
+    if (flow.ackDue(now)) flushAck(sess);
+    return sent;
+}
 
-bool Network::createSocket() {
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    return sockfd >= 0;
+void Network::windowClosed(const sockaddr_in& to, uint32_t need) {
+    probeTo = to;
+    flow.blocked(nowMs(), rtt.rto, need);
+}
+
+void Network::deferAck(const sockaddr_in& to) {
+    ackTo = to;
+    flow.defer(nowMs());
+}
+
+Network::Network()
+: cc(std::make_unique<NewRenoController>()) {
+    rtt.rto = INITIAL_RTO_MS;
+}
+
+/**
+ * @brief Cria o pool na primeira transmissão, dimensionado para a maior
+ *        janela anunciável (16 bits); a fila de pendentes tem a mesma
+ *        capacidade, já que cada pendente ocupa um slot.
+ */
+void Network::ensurePool() {
+    if (pool) return;
+    pool = std::make_unique<PacketPool>(PacketPool::slotsForWindow(UINT16_MAX));
+    pend.reserve(pool->capacity());
+}
+
+/**
+ * @brief Pacotes com dados ou de controle ficam para retransmissão.
+ */
+bool Network::retained(const SlowPacketView& pkt) {
+    return !pkt.data.empty() || (pkt.flags & (CONNECT | REVIVE));
+}
+Network::~Network() {
+    closeSocket();
+    for (size_t i = 0; i < metrics::GAUGES; ++i) metrics::add(metrics::Gauge(i), -shown[i]);
+}
+
+bool Network::createSocket(const string& backend) {
+    io = makeTransport(backend);
+    ownsIo = true;
+    return io && io->open();
+}
+
+void Network::attach(shared_ptr<Transport> t) {
+    io = std::move(t);
+    ownsIo = false;
+}
+
+void Network::impair(const ImpairedTransport::Config& cfg) {
+    if (io) io = make_shared<ImpairedTransport>(io, cfg);
+}
+
+/**
+ * @brief Contabiliza um pacote que de fato saiu pelo socket.
+ *
+ * Pacotes com dados (ou de controle) vão para a fila de retransmissão
+ * levando o slot do pool; pure-ACKs não consomem seqnum e nunca são
+ * retransmitidos.
+ */
+void Network::commitSent(const sockaddr_in& addr, const SlowPacketView& pkt, PacketRef buf, Session& sess) {
+    sess.bytesInFlight += pkt.data.size();
+    peer = addr;
+    if (buf) pushPending(std::move(buf), pkt.data, pkt.seqnum);
+    if (cache) cache->save(sess, pkt.seqnum);
+    // todo pacote com ACK leva o acknum corrente: dispensa o ACK pendente
+    if (flow.ackPending() && (pkt.flags & ACK) && pkt.acknum == sess.acknum) {
+        if (!pkt.data.empty()) metrics::add(metrics::Counter::PiggybackedAcks);
+        flow.acked();
+    }
+    metrics::add(metrics::Counter::TxPackets);
+    metrics::add(metrics::Counter::TxBytes, HDR_SIZE + pkt.data.size());
+    publishGauges(sess);
 }
 
 /**
  * @brief Envia um pacote pela rede e gerencia janela de envio.
  */
-bool Network::sendPacket(const sockaddr_in& addr, const SlowPacket& pkt, uint32_t& lastSeq, Session& sess) {
-    uint8_t buf[MAX_PACKET]; size_t len;
-    pkt.serialize(buf, len);
-    logPacket(pkt, "TX");
-    if (!pkt.data.empty()) {
-        size_t show = min<size_t>(50, pkt.data.size());
-        string prev(pkt.data.begin(), pkt.data.begin() + show);
-        cout << "✉  DATA (" << pkt.data.size() << " B): \"" << prev << (pkt.data.size() > show ? "…" : "") << "\"\n\n";
+bool Network::sendPacket(const sockaddr_in& addr, const SlowPacketView& pkt, uint32_t& lastSeq, Session& sess) {
+    ensurePool();
+    PacketRef slot;
+    if (retained(pkt) && !(slot = pool->acquire())) {
+        SLOW_LOG(Debug, Flow, "[FLOW] sem buffer livre, aguardando ACK");
+        metrics::add(metrics::Counter::BufferStalls);
+        lastSeq = pkt.seqnum;
+        return false;
     }
-    // se exceder a janela da outra ponta, aguarda ACK
-    if (sess.bytesInFlight + pkt.data.size() > sess.remoteWindow) {
-        cerr << "[FLOW] janela cheia, aguardando ACK\n";
+    uint8_t ack[HDR_SIZE];
+    uint8_t* hdr = slot ? slot.data() : ack;
+    pkt.serializeHeader(hdr);
+    SLOW_LOG_PACKET(Debug, "TX", pkt);
+    // se exceder a janela da outra ponta (ou a cwnd), aguarda ACK
+    if (sess.bytesInFlight + pkt.data.size() > sendWindow(sess)) {
+        SLOW_LOG(Debug, Flow, "[FLOW] janela cheia, aguardando ACK");
+        metrics::add(metrics::Counter::WindowStalls);
         lastSeq = pkt.seqnum;
         return false;
     }
-    ssize_t sent = ::sendto(sockfd, buf, len, 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
-    if (sent != static_cast<ssize_t>(len)) return false;
-    sess.bytesInFlight += pkt.data.size();
+    OutDatagram d;
+    d.iov[0] = {hdr, HDR_SIZE};
+    d.iov[1] = {const_cast<uint8_t*>(pkt.data.data()), pkt.data.size()};
+    if (io->send(addr, &d, 1) != 1) return false;
+    if (cap) cap->record(Capture::Tx, addr, d);
     lastSeq = pkt.seqnum;
-    // se for pacote com dados, adiciona à fila para retransmissão
-    pushPending(buf, len, pkt.seqnum, pkt.data.size());
+    commitSent(addr, pkt, std::move(slot), sess);
     return true;
 }
 
 /**
- * @brief Tenta receber um pacote, com timeout e suporte a retransmissão.
+ * @brief Envia vários pacotes com uma única chamada sendmmsg.
+ *
+ * Só os cabeçalhos são serializados, direto no slot do pool que guardará
+ * o pacote para retransmissão; cada datagrama aponta para o seu payload
+ * original. A janela é verificada cumulativamente e o lote é cortado no
+ * primeiro pacote que não couber (ou sem slot livre). O lote inteiro vai
+ * ao backend de uma vez.
  */
-bool Network::receivePacket(SlowPacket& pkt, sockaddr_in& from, Session& sess) {
-    uint8_t buf[MAX_PACKET]; socklen_t alen = sizeof(from);
-    fd_set rf; FD_ZERO(&rf); FD_SET(sockfd, &rf);
-    // espera até 500ms por um pacote
-    timeval tv{0, 500000};
-    int ready = select(sockfd + 1, &rf, nullptr, nullptr, &tv);
-    if (ready == 0) {
-        retransmit(from, sess);
-        return false;
+size_t Network::sendBatch(const sockaddr_in& addr, const SlowPacketView* pkts, size_t n, Session& sess) {
+    n = min(n, MAX_BATCH);
+    ensurePool();
+    OutDatagram dg[MAX_BATCH];
+    PacketRef slots[MAX_BATCH];
+    uint32_t win = sendWindow(sess);
+    uint64_t inFlight = sess.bytesInFlight;
+    size_t cnt = 0;
+    for (; cnt < n; ++cnt) {
+        if (inFlight + pkts[cnt].data.size() > win) {
+            SLOW_LOG(Debug, Flow, "[FLOW] janela cheia, aguardando ACK");
+            metrics::add(metrics::Counter::WindowStalls);
+            break;
+        }
+        if (retained(pkts[cnt]) && !(slots[cnt] = pool->acquire())) {
+            SLOW_LOG(Debug, Flow, "[FLOW] sem buffer livre, aguardando ACK");
+            metrics::add(metrics::Counter::BufferStalls);
+            break;
+        }
+        inFlight += pkts[cnt].data.size();
+        uint8_t* hdr = slots[cnt] ? slots[cnt].data() : txHdrs[cnt].data();
+        pkts[cnt].serializeHeader(hdr);
+        dg[cnt].iov[0] = {hdr, HDR_SIZE};
+        dg[cnt].iov[1] = {const_cast<uint8_t*>(pkts[cnt].data.data()), pkts[cnt].data.size()};
+        SLOW_LOG_PACKET(Debug, "TX", pkts[cnt]);
     }
-    ssize_t n = recvfrom(sockfd, buf, MAX_PACKET, 0, reinterpret_cast<sockaddr*>(&from), &alen);
-    if (n < HDR_SIZE) return false;
-    pkt.deserialize(buf, n);
-    logPacket(pkt, "RX");
-    if (!pkt.data.empty()) {
-        size_t show = min<size_t>(50, pkt.data.size());
-        string prev(pkt.data.begin(), pkt.data.begin() + show);
-        cout << "✉  DATA (" << pkt.data.size() << " B): \"" << prev << (pkt.data.size() > show ? "…" : "") << "\"\n\n";
+    if (!cnt) return 0;
+
+    size_t sent = io->send(addr, dg, cnt);
+    for (size_t i = 0; i < sent; ++i) {
+        if (cap) cap->record(Capture::Tx, addr, dg[i]);
+        commitSent(addr, pkts[i], std::move(slots[i]), sess);
     }
+    return sent;
+}
+
+/**
+ * @brief Espera o socket ficar legível por até RECV_WAIT_MS.
+ *
+ * Acorda em cada deadline de retransmissão para reenviar o que venceu.
+ * @return true se há datagramas para ler.
+ */
+bool Network::waitReadable(Session& sess) {
+    uint64_t limit = nowMs() + RECV_WAIT_MS;
+    while (true) {
+        service(sess);
+        uint64_t now = nowMs();
+        if (now >= limit) return false;
+        uint64_t wake = min(limit, max(nextDeadline(), now));
+        if (io->wait(wake - now)) return true;
+    }
+}
+
+/**
+ * @brief Decodifica um datagrama e aplica seus efeitos na sessão.
+ */
+bool Network::handleDatagram(const Datagram& dg, SlowPacketView& pkt, Session& sess) {
+    if (cap) cap->record(Capture::Rx, dg.from, dg.data, dg.len);
+    if (!pkt.parse(dg.data, dg.len)) return false;
+    SLOW_LOG_PACKET(Debug, "RX", pkt);
+    heard = nowMs();
+    metrics::add(metrics::Counter::RxPackets);
+    metrics::add(metrics::Counter::RxBytes, dg.len);
     // atualiza sttl e controle de janela
     sess.sttl = pkt.sttl;
-    if (pkt.flags & ACK) {
-        dropAcked(pkt.acknum, sess);
-        sess.remoteWindow = pkt.window;
+    if (pkt.flags & (ACK | ACCEPT)) onAck(pkt, sess);
+    if (rx && !pkt.data.empty() && !(pkt.flags & (CONNECT | REVIVE | ACCEPT))) {
+        rx->push(pkt, sess);
+        flow.received(heard);
+        ackTo = dg.from;
     }
+    if (cache) cache->save(sess);
+    publishGauges(sess);
     return true;
 }
 
+/**
+ * @brief Pure-ACK com o estado corrente (ACK cumulativo ou probe de janela).
+ */
+void Network::sendPureAck(const sockaddr_in& to, Session& sess) {
+    SlowPacketView a;
+    a.sid = ByteSpan(sess.sid.data(), sess.sid.size());
+    a.flags = ACK;
+    a.seqnum = sess.seqnum;
+    a.acknum = sess.acknum;
+    a.window = sess.recvWindow;
+    a.sttl = sess.sttl;
+    uint32_t dummy;
+    sendPacket(to, a, dummy, sess);
+}
+
+void Network::flushAck(Session& sess) {
+    if (flow.ackPending()) sendPureAck(ackTo, sess);
+}
+
+bool Network::onDatagram(const Datagram& dg, SlowPacketView& pkt, Session& sess) {
+    if (!handleDatagram(dg, pkt, sess)) return false;
+    if (flow.ackDue(nowMs())) flushAck(sess);
+    return true;
+}
+
+/**
+ * @brief Tenta receber um pacote, com timeout e suporte a retransmissão.
+ */
+bool Network::receivePacket(SlowPacket& pkt, sockaddr_in& from, Session& sess) {
+    SlowPacketView v;
+    bool got = receiveBatch(&v, 1, from, sess) == 1;
+    if (got) pkt = v.toPacket();
+    flushAck(sess); // troca pontual: quem chama pode não enviar mais nada
+    return got;
+}
+
+/**
+ * @brief Recebe de uma vez todos os datagramas enfileirados (até `max`).
+ *
+ * Espera como receivePacket pelo primeiro; os demais são drenados do
+ * backend sem bloquear. Datagramas curtos demais são descartados e não
+ * ocupam posição em `out`.
+ */
+size_t Network::receiveBatch(SlowPacketView* out, size_t max, sockaddr_in& from, Session& sess) {
+    max = min(max, MAX_BATCH);
+    if (!max || !waitReadable(sess)) return 0;
+    Datagram dg[MAX_BATCH];
+    size_t n = io->recv(dg, max), got = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (handleDatagram(dg[i], out[got], sess)) { from = dg[i].from; ++got; }
+    // ACK_EVERY pacotes com dados ou prazo vencido; senão vai de carona
+    if (flow.ackDue(nowMs())) flushAck(sess);
+    return got;
+}
+
+bool Network::enableOffload() { return io && io->enableOffload(); }
+bool Network::offloadActive() const { return io && io->offloadActive(); }
+
 void Network::closeSocket() {
-    if (sockfd >= 0) close(sockfd);
-    sockfd = -1;
-}
\ No newline at end of file
+    if (io && ownsIo) io->close();
+}
@@ -1,4 +1,5 @@
 #include "packet.h"
+#include "log.h"
 #include <cstring>
 #include <iostream>
 
@@ -18,10 +19,10 @@ using namespace std;
 SlowPacket::SlowPacket() noexcept {}
 
 /**
- * @brief Exibe o cabeçalho do pacote em formato “caixa” (debug).
+ * @brief Registra o cabeçalho do pacote no log (formato “caixa” no sink padrão).
  */
 void SlowPacket::printVerbose() const {
-    logPacket(*this, "PACKET VERBOSE");
+    SLOW_LOG_PACKET(Debug, "PACKET VERBOSE", SlowPacketView(*this));
 }
 
 /**
@@ -54,16 +55,13 @@ uint32_t unpackLE(const uint8_t* p, int n) {
 }
 
 /**
- * @brief Constrói o buffer on-wire a partir da estrutura em memória.
- *
- * @param buf Buffer destino (≥ 1472 B).
- * @param len Devolve o total de bytes gravados.
+ * @brief Escreve o cabeçalho on-wire (HDR_SIZE bytes).
  *
  * A função escreve cada campo na ordem definida pelo protocolo.
  * O par `(sttl, flags)` é compactado em um único word LE:
  * `sf = (sttl << 5) | flags`.
  */
-void SlowPacket::serialize(uint8_t* buf, size_t& len) const {
+void SlowPacketView::serializeHeader(uint8_t* buf) const {
     size_t off = 0;
     memcpy(buf + off, sid.data(), UUID_SIZE); off += UUID_SIZE;
 
@@ -75,23 +73,18 @@ void SlowPacket::serialize(uint8_t* buf, size_t& len) const {
 
     buf[off++] = fid;
     buf[off++] = fo;
-
-    if (!data.empty()) {
-        memcpy(buf + off, data.data(), data.size());
-        off += data.size();
-    }
-    len = off;
 }
 
 /**
- * @brief Lê um buffer on-wire e preenche a estrutura em memória.
+ * @brief Decodifica o cabeçalho no próprio buffer de recepção.
  *
  * @param buf Buffer de entrada.
  * @param len Número de bytes válidos em `buf`.
  */
-void SlowPacket::deserialize(const uint8_t* buf, size_t len) {
+bool SlowPacketView::parse(const uint8_t* buf, size_t len) {
+    if (len < size_t(HDR_SIZE)) return false;
     size_t off = 0;
-    memcpy(sid.data(), buf + off, UUID_SIZE); off += UUID_SIZE;
+    sid = ByteSpan(buf + off, UUID_SIZE); off += UUID_SIZE;
 
     uint32_t sf = unpackLE(buf + off, 4); off += 4;
     flags = sf & 0x1Fu;
@@ -104,6 +97,52 @@ void SlowPacket::deserialize(const uint8_t* buf, size_t len) {
     fid = buf[off++];
     fo = buf[off++];
 
-    data.clear();
-    if (len > off) data.assign(buf + off, buf + len);
-}
\ No newline at end of file
+    data = ByteSpan(buf + off, len - off);
+    return true;
+}
+
+SlowPacket SlowPacketView::toPacket() const {
+    SlowPacket p;
+    std::copy(sid.begin(), sid.end(), p.sid.begin());
+    p.flags = flags;
+    p.sttl = sttl;
+    p.seqnum = seqnum;
+    p.acknum = acknum;
+    p.window = window;
+    p.fid = fid;
+    p.fo = fo;
+    p.data.assign(data.begin(), data.end());
+    return p;
+}
+
+/**
+ * @brief Constrói o buffer on-wire a partir da estrutura em memória.
+ *
+ * @param buf Buffer destino (≥ 1472 B).
+ * @param len Devolve o total de bytes gravados.
+ */
+void SlowPacket::serialize(uint8_t* buf, size_t& len) const {
+    SlowPacketView(*this).serializeHeader(buf);
+    if (!data.empty()) memcpy(buf + HDR_SIZE, data.data(), data.size());
+    len = HDR_SIZE + data.size();
+}
+
+/**
+ * @brief Lê um buffer on-wire e preenche a estrutura em memória.
+ *
+ * @param buf Buffer de entrada.
+ * @param len Número de bytes válidos em `buf`.
+ */
+void SlowPacket::deserialize(const uint8_t* buf, size_t len) {
+    SlowPacketView v;
+    if (!v.parse(buf, len)) { data.clear(); return; }
+    std::copy(v.sid.begin(), v.sid.end(), sid.begin());
+    flags = v.flags;
+    sttl = v.sttl;
+    seqnum = v.seqnum;
+    acknum = v.acknum;
+    window = v.window;
+    fid = v.fid;
+    fo = v.fo;
+    data.assign(v.data.begin(), v.data.end()); // reaproveita a capacidade
+}
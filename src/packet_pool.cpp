@@ -0,0 +1,38 @@
+#include "packet_pool.h"
+
+/**
+ * @file    packet_pool.cpp
+ * @brief   Implementação do pool de buffers de pacote.
+ */
+
+static constexpr size_t CONTROL_SLOTS = 2; // CONNECT/REVIVE/disconnect em voo junto com dados
+
+PacketPool::PacketPool(size_t slots) : mem(slots * SLOT_SIZE), refs(slots, 0) {
+    freeList.reserve(slots);
+    for (size_t i = slots; i-- > 0;) freeList.push_back(uint32_t(i));
+}
+
+size_t PacketPool::slotsForWindow(uint32_t window) {
+    return (window + MAX_DATA - 1) / MAX_DATA + CONTROL_SLOTS;
+}
+
+PacketRef PacketPool::acquire() {
+    if (freeList.empty()) return {};
+    uint32_t i = freeList.back();
+    freeList.pop_back();
+    refs[i] = 1;
+    return PacketRef(this, i);
+}
+
+PacketRef::PacketRef(const PacketRef& o) : pool(o.pool), idx(o.idx) {
+    if (pool) ++pool->refs[idx];
+}
+
+uint8_t* PacketRef::data() const {
+    return pool ? pool->mem.data() + size_t(idx) * PacketPool::SLOT_SIZE : nullptr;
+}
+
+void PacketRef::reset() {
+    if (pool && --pool->refs[idx] == 0) pool->freeList.push_back(idx);
+    pool = nullptr;
+}
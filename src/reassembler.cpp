@@ -0,0 +1,164 @@
+#include "reassembler.h"
+#include "network.h"
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+/**
+ * @file    reassembler.cpp
+ * @brief   Implementação da remontagem e do ACK cumulativo.
+ *
+ * O buffer é dividido em slots de MAX_DATA; cada fragmento ocupa um slot
+ * até a mensagem ficar completa, quando é copiada (em ordem de FO) para
+ * um buffer de entrega reutilizado e os slots voltam à lista livre.
+ * Mensagens de um único datagrama são entregues direto do pacote.
+ */
+
+size_t Reassembler::SidHash::operator()(const Sid& s) const {
+    uint64_t v;
+    memcpy(&v, s.data(), sizeof v);
+    return size_t(v);
+}
+
+size_t Reassembler::KeyHash::operator()(const Key& k) const {
+    return SidHash()(k.sid) ^ (size_t(k.fid) * 0x9E3779B97F4A7C15ull);
+}
+
+Reassembler::Reassembler(size_t slots, uint16_t maxWin)
+: slotCount(min<size_t>(slots, NO_SLOT)), maxWindow(maxWin), arena(slotCount * MAX_DATA) {
+    freeSlots.reserve(slotCount);
+    for (size_t i = slotCount; i-- > 0;) freeSlots.push_back(uint16_t(i));
+}
+
+uint16_t Reassembler::window() const {
+    return uint16_t(min<size_t>(freeSlots.size() * MAX_DATA, maxWindow));
+}
+
+void Reassembler::release(Assembly& a) {
+    for (uint16_t& s : a.slot)
+        if (s != NO_SLOT) { freeSlots.push_back(s); s = NO_SLOT; }
+}
+
+/**
+ * @brief Libera mensagens incompletas paradas há mais de STALE_MS.
+ * @return true se algum slot foi liberado.
+ */
+bool Reassembler::evictStale(uint64_t now) {
+    size_t before = freeSlots.size();
+    for (auto it = parts.begin(); it != parts.end();) {
+        if (now - it->second.touched >= STALE_MS) { release(it->second); it = parts.erase(it); }
+        else ++it;
+    }
+    return freeSlots.size() > before;
+}
+
+/**
+ * @brief Cede o slot do fragmento da sessão com maior seqnum acima de
+ *        `seq` (e do cumulativo): ele ainda não foi confirmado, então o
+ *        peer o reenviará.
+ * @return true se um slot foi liberado.
+ */
+bool Reassembler::evictAhead(const Sid& sid, Flow& f, uint32_t seq) {
+    Assembly* victim = nullptr;
+    int vfo = -1;
+    uint32_t best = seq;
+    for (auto& [k, a] : parts) {
+        if (k.sid != sid) continue;
+        for (int fo = 0; fo < 256; ++fo)
+            if (a.slot[fo] != NO_SLOT && int32_t(a.seq[fo] - best) > 0 && int32_t(a.seq[fo] - f.next) >= 0) {
+                best = a.seq[fo]; victim = &a; vfo = fo;
+            }
+    }
+    if (!victim) return false;
+    freeSlots.push_back(victim->slot[vfo]);
+    victim->slot[vfo] = NO_SLOT;
+    --victim->have;
+    if (victim->lastFo == vfo) victim->lastFo = -1;
+    f.seen[best % SEQ_WINDOW] = false;
+    return true;
+}
+
+/**
+ * @brief Junta os fragmentos em ordem de FO e entrega a mensagem.
+ */
+void Reassembler::complete(const Key& k, Assembly& a) {
+    out.clear();
+    for (int fo = 0; fo <= a.lastFo; ++fo) {
+        const uint8_t* src = arena.data() + size_t(a.slot[fo]) * MAX_DATA;
+        out.insert(out.end(), src, src + a.len[fo]);
+    }
+    release(a);
+    if (deliver) deliver(ByteSpan(k.sid.data(), k.sid.size()), k.fid, ByteSpan(out.data(), out.size()));
+}
+
+/**
+ * @brief Guarda (ou entrega) o payload de um pacote ainda não visto.
+ */
+Reassembler::Result Reassembler::store(const SlowPacketView& p, const Sid& sid, Flow& f) {
+    Key k{sid, p.fid};
+    auto it = parts.find(k);
+
+    // mensagem de um datagrama só: entrega sem passar pelo buffer
+    if (!(p.flags & MOREBITS) && p.fo == 0 && it == parts.end()) {
+        if (deliver) deliver(ByteSpan(sid.data(), sid.size()), p.fid, p.data);
+        return Result::Delivered;
+    }
+
+    if (it != parts.end() && it->second.slot[p.fo] != NO_SLOT) return Result::Duplicate;
+    uint64_t now = nowMs();
+    if (freeSlots.empty() && !evictAhead(sid, f, p.seqnum) && !evictStale(now)) return Result::NoSpace;
+
+    Assembly& a = it != parts.end() ? it->second : parts[k];
+    uint16_t s = freeSlots.back();
+    freeSlots.pop_back();
+    memcpy(arena.data() + size_t(s) * MAX_DATA, p.data.data(), p.data.size());
+    a.slot[p.fo] = s;
+    a.len[p.fo] = uint16_t(p.data.size());
+    a.seq[p.fo] = p.seqnum;
+    a.touched = now;
+    ++a.have;
+    if (!(p.flags & MOREBITS)) a.lastFo = p.fo;
+
+    if (a.lastFo < 0 || a.have != size_t(a.lastFo) + 1) return Result::Buffered;
+    complete(k, a);
+    parts.erase(k);
+    return Result::Delivered;
+}
+
+Reassembler::Result Reassembler::push(const SlowPacketView& p, Session& s) {
+    if (p.data.empty() || p.data.size() > MAX_DATA) return Result::Ignored;
+
+    Sid sid;
+    copy(p.sid.begin(), p.sid.end(), sid.begin());
+    auto fit = flows.find(sid);
+    if (fit == flows.end()) {
+        fit = flows.emplace(sid, Flow{}).first;
+        fit->second.next = s.acknum + 1;   // primeiro dado depois do SETUP
+    }
+    Flow& f = fit->second;
+
+    Result r;
+    uint32_t ahead = p.seqnum - f.next;
+    if (int32_t(ahead) < 0) r = Result::Duplicate;
+    else if (ahead >= SEQ_WINDOW) r = Result::NoSpace;
+    else if (f.seen[p.seqnum % SEQ_WINDOW]) r = Result::Duplicate;
+    else {
+        r = store(p, sid, f);
+        if (r != Result::NoSpace) {
+            f.seen[p.seqnum % SEQ_WINDOW] = true;
+            while (f.seen[f.next % SEQ_WINDOW]) f.seen[f.next++ % SEQ_WINDOW] = false;
+        }
+    }
+
+    s.acknum = f.next - 1;
+    s.recvWindow = window();
+    return r;
+}
+
+void Reassembler::forget(const Session& s) {
+    flows.erase(s.sid);
+    for (auto it = parts.begin(); it != parts.end();) {
+        if (it->first.sid == s.sid) { release(it->second); it = parts.erase(it); }
+        else ++it;
+    }
+}
@@ -0,0 +1,114 @@
+#include "sender.h"
+#include "log.h"
+#include "packet.h"
+#include <algorithm>
+using namespace std;
+
+/**
+ * @file    sender.cpp
+ * @brief   Implementação do envio em janela deslizante.
+ *
+ * Cada fragmento sai assim que houver espaço na janela remota; os ACKs
+ * cumulativos liberam `bytesInFlight` dentro de Network::receivePacket
+ * e o laço volta a preencher a janela.
+ */
+
+Sender::Sender(Network& n, const sockaddr_in& d, Session& s)
+: net(n), dst(d), sess(s), tx(Network::MAX_BATCH), rx(Network::MAX_BATCH) {}
+
+/**
+ * @brief Drena de uma vez todos os ACKs enfileirados.
+ */
+bool Sender::pump() {
+    sockaddr_in from{};
+    size_t n = net.receiveBatch(rx.data(), rx.size(), from, sess);
+    for (size_t i = 0; i < n; ++i) onAck(rx[i]);
+    return n > 0;
+}
+
+void Sender::onAck(const SlowPacketView& a) {
+    if (!(a.flags & ACK)) return;
+    // o acknum de pacotes com dados é do Reassembler (cumulativo)
+    if (a.data.empty()) sess.acknum = a.seqnum;
+    SLOW_LOG(Debug, Flow, "✓ ACK {} (em voo: {} B)", a.acknum, sess.bytesInFlight);
+    SLOW_LOG(Debug, Flow, "[debug] Janela atualizada: {}", a.window);
+}
+
+size_t Sender::segment() const {
+    // janela zero é momentânea: fragmentos de 1 B durariam a mensagem toda
+    return sess.remoteWindow ? min<size_t>(MAX_DATA, sess.remoteWindow) : MAX_DATA;
+}
+
+bool Sender::begin(const uint8_t* d, size_t l) {
+    if (l > maxMessage()) {
+        SLOW_LOG(Error, App, "[erro] mensagem de {} B excede {} fragmentos", l, MAX_FRAGS);
+        data = nullptr; len = off = 0;
+        return false;
+    }
+    data = d;
+    len = l;
+    off = 0;
+    dropBase = net.droppedBytes();
+    seg = segment();
+    willFrag = len > seg;
+    // mensagens seguidas não podem repetir o FID: o peer ainda pode
+    // estar remontando a anterior
+    uint8_t prev = fid;
+    if (willFrag) do fid = Session::generateUUID()[0]; while (!fid || fid == prev);
+    fo = 0;
+    return true;
+}
+
+size_t Sender::fill() {
+    // monta um lote com quantos fragmentos couberem na janela
+    size_t n = 0, batchOff = off;
+    uint32_t win = net.sendWindow(sess);
+    uint64_t inFlight = sess.bytesInFlight;
+    while (batchOff < len && n < tx.size()) {
+        size_t chunk = min(seg, len - batchOff);
+        if (inFlight + chunk > win) break;
+
+        SlowPacketView& p = tx[n++];
+        p.sid = ByteSpan(sess.sid.data(), sess.sid.size());
+        p.flags = ACK | ((batchOff + chunk < len) ? MOREBITS : 0);
+        p.seqnum = sess.seqnum + n;
+        p.acknum = sess.acknum;
+        p.window = sess.recvWindow;
+        p.sttl = sess.sttl;
+        p.fid = willFrag ? fid : 0;
+        p.fo = willFrag ? uint8_t(fo + n - 1) : 0;
+        p.data = ByteSpan(data + batchOff, chunk);
+        inFlight += chunk;
+        batchOff += chunk;
+    }
+
+    // uma syscall para o lote inteiro; só o prefixo enviado avança o estado
+    size_t sent = n ? net.sendBatch(dst, tx.data(), n, sess) : 0;
+    for (size_t i = 0; i < sent; ++i) off += tx[i].data.size();
+    sess.seqnum += sent;
+    if (willFrag) fo += sent;
+
+    // janela fechada (ou menor que o fragmento) e nada em voo: nenhum ACK
+    // virá sozinho
+    if (!sent && off < len && !net.pendingCount()) net.windowClosed(dst, uint32_t(min(seg, len - off)));
+    return sent;
+}
+
+bool Sender::send(const uint8_t* d, size_t l) {
+    if (!begin(d, l)) return false;
+    int idle = 0;
+    while (!done()) {
+        fill();
+        if (pump()) idle = 0;
+        else if (++idle >= MAX_IDLE) {
+            SLOW_LOG(Error, App, "[erro] sem resposta do servidor, envio abortado");
+            return false;
+        }
+    }
+    net.flushAck(sess);
+    if (lost()) {
+        SLOW_LOG(Error, App, "[erro] fragmento descartado sem confirmação");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,198 @@
+#include "server.h"
+#include "network.h"
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+/**
+ * @file    server.cpp
+ * @brief   Implementação do servidor SLOW de referência.
+ *
+ * Cada sessão guarda só o cumulativo e dois bitmaps dos seqnums à
+ * frente dele: o servidor conta bytes e mensagens, mas não remonta nem
+ * guarda payload, o que mantém milhares de sessões em poucos KB cada.
+ */
+
+size_t SlowServer::SidHash::operator()(const Sid& s) const {
+    uint64_t v;
+    memcpy(&v, s.data(), sizeof v);
+    return size_t(v);
+}
+
+SlowServer::SlowServer(shared_ptr<Transport> t, const Config& c)
+: io(std::move(t)), cfg(c), rng(c.seed ? c.seed : random_device{}()), timers(100, 1024), rx(MAX_BATCH) {
+    outq.reserve(MAX_BATCH);
+}
+
+/**
+ * @brief Janela anunciada: a configurada menos o que está fora de ordem.
+ */
+uint16_t SlowServer::window(const Peer& s) const {
+    uint32_t held = s.ahead * uint32_t(MAX_DATA);
+    return held >= cfg.window ? 0 : uint16_t(cfg.window - held);
+}
+
+void SlowServer::reply(const Peer& s, uint8_t flags, uint32_t seq, uint32_t ack) {
+    SlowPacketView r;
+    r.sid = ByteSpan(s.sid.data(), s.sid.size());
+    r.flags = flags;
+    r.sttl = cfg.sttlMs;
+    r.seqnum = seq;
+    r.acknum = ack;
+    r.window = window(s);
+    outq.push_back({s.addr, {}});
+    r.serializeHeader(outq.back().hdr.data());
+    ++stats.txPackets;
+}
+
+void SlowServer::setOpen(Peer& s, bool o) {
+    if (s.open == o) return;
+    s.open = o;
+    if (o) ++open;
+    else --open;
+}
+
+/**
+ * @brief CONNECT: nova sessão com SID (UUIDv8) e seqnum inicial aleatórios.
+ */
+void SlowServer::accept(const SlowPacketView&, const sockaddr_in& from, uint64_t now) {
+    uint32_t id = nextId++;
+    Peer& s = byId[id];
+    do {
+        uint64_t a = rng(), b = rng();
+        memcpy(s.sid.data(), &a, 8);
+        memcpy(s.sid.data() + 8, &b, 8);
+        s.sid[6] = (s.sid[6] & 0x0F) | 0x80;
+        s.sid[8] = (s.sid[8] & 0x3F) | 0x80;
+    } while (bySid.count(s.sid));
+    bySid[s.sid] = id;
+    s.addr = from;
+    s.seq = 1 + uint32_t(rng() % 1000000);
+    s.next = s.seq + 2; // o ACK do handshake usa seq+1 sem consumi-lo
+    s.lastSeen = now;
+    ++open;
+    ++stats.accepted;
+    timers.schedule(id, now + cfg.sttlMs);
+    reply(s, ACCEPT, s.seq, 0);
+}
+
+/**
+ * @brief Registra um dado e responde com o eco do seqnum e o cumulativo.
+ */
+void SlowServer::data(Peer& s, const SlowPacketView& p) {
+    uint32_t ahead = p.seqnum - s.next;
+    size_t i = p.seqnum % SEQ_WINDOW;
+    if (int32_t(ahead) < 0 || (ahead < SEQ_WINDOW && s.seen[i])) ++stats.duplicates;
+    else if (ahead < SEQ_WINDOW) {
+        stats.dataBytes += p.data.size();
+        s.seen[i] = true;
+        s.last[i] = !(p.flags & MOREBITS);
+        ++s.ahead;
+        for (size_t j; s.seen[j = s.next % SEQ_WINDOW]; ++s.next) {
+            if (s.last[j]) ++stats.messages;
+            s.seen[j] = false;
+            --s.ahead;
+        }
+    }
+    // além da janela de rastreio: só repete o cumulativo
+    reply(s, ACK, p.seqnum, s.next - 1);
+}
+
+void SlowServer::onDatagram(const Datagram& dg, uint64_t now) {
+    ++stats.rxPackets;
+    SlowPacketView p;
+    if (!p.parse(dg.data, dg.len)) return;
+
+    Sid sid;
+    copy(p.sid.begin(), p.sid.end(), sid.begin());
+    if (sid == Sid{}) {
+        if ((p.flags & CONNECT) && !(p.flags & REVIVE)) accept(p, dg.from, now);
+        else ++stats.unknown;
+        return;
+    }
+    auto it = bySid.find(sid);
+    if (it == bySid.end()) { ++stats.unknown; return; }
+    Peer& s = byId[it->second];
+    s.addr = dg.from; // o cliente pode voltar de outra porta (revive)
+
+    if ((p.flags & (CONNECT | REVIVE)) == (CONNECT | REVIVE)) {
+        // disconnect; repetido se o nosso ACK se perdeu
+        if (s.open) { setOpen(s, false); ++stats.closed; }
+        s.lastSeen = now;
+        reply(s, ACK, 0, 0);
+        return;
+    }
+    if (p.flags & REVIVE) {
+        setOpen(s, true);
+        s.next = p.seqnum + 1;
+        s.seen.reset();
+        s.last.reset();
+        s.ahead = 0;
+        s.lastSeen = now;
+        stats.dataBytes += p.data.size();
+        ++stats.revived;
+        reply(s, ACCEPT | ACK, s.seq, p.seqnum);
+        return;
+    }
+    if (!s.open) { ++stats.unknown; return; }
+
+    s.lastSeen = now;
+    // pure-ACK (fim do handshake, sonda de janela, keep-alive): responde
+    // com a janela corrente sem indicar nenhum seqnum como recebido
+    if (p.data.empty()) reply(s, ACK, s.next - 1, s.next - 1);
+    else data(s, p);
+}
+
+void SlowServer::onTimer(uint64_t now) {
+    expired.clear();
+    timers.expire(now, expired);
+    for (uint32_t id : expired) {
+        auto it = byId.find(id);
+        if (it == byId.end()) continue;
+        Peer& s = it->second;
+        uint64_t due = s.lastSeen + cfg.sttlMs;
+        if (due > now) { timers.schedule(id, due); continue; }
+        if (s.open) {
+            // expirou: ainda pode ser revivida por mais um STTL
+            setOpen(s, false);
+            ++stats.expired;
+            s.lastSeen = now;
+            timers.schedule(id, now + cfg.sttlMs);
+            continue;
+        }
+        bySid.erase(s.sid);
+        byId.erase(it);
+    }
+}
+
+void SlowServer::flush() {
+    OutDatagram d[MAX_BATCH];
+    for (size_t i = 0; i < outq.size();) {
+        const sockaddr_in& to = outq[i].to;
+        size_t n = 0;
+        while (i + n < outq.size() && n < MAX_BATCH && outq[i + n].to.sin_port == to.sin_port &&
+               outq[i + n].to.sin_addr.s_addr == to.sin_addr.s_addr) {
+            d[n].iov[0] = {outq[i + n].hdr.data(), HDR_SIZE};
+            ++n;
+        }
+        io->send(to, d, n);
+        i += n;
+    }
+    outq.clear();
+}
+
+size_t SlowServer::runOnce(uint64_t timeoutMs) {
+    uint64_t now = nowMs(), next = timers.nextDeadline();
+    uint64_t wait = next <= now ? 0 : min(timeoutMs, next - now);
+    size_t total = 0;
+    if (io->wait(wait)) {
+        // drena o que já chegou, respondendo a cada lote
+        for (size_t n; total < 16 * MAX_BATCH && (n = io->recv(rx.data(), rx.size())) > 0; total += n) {
+            now = nowMs();
+            for (size_t i = 0; i < n; ++i) onDatagram(rx[i], now);
+            flush();
+        }
+    }
+    onTimer(nowMs());
+    return total;
+}
@@ -1,4 +1,5 @@
 #include "session.h"
+#include <optional>
 #include <random>
 
 /**
@@ -16,6 +17,11 @@ Session::Session() noexcept { sid = nilUUID(); }
 /* UUID todo zero (16 bytes) */
 std::array<uint8_t, 16> Session::nilUUID() { return {}; }
 
+// gerador da thread corrente depois de seedUUID()
+static thread_local std::optional<std::mt19937_64> seeded;
+
+void Session::seedUUID(uint64_t seed) { seeded.emplace(seed); }
+
 /**
  * @brief Gera um UUID pseudo-aleatório.
  *
@@ -24,8 +30,11 @@ std::array<uint8_t, 16> Session::nilUUID() { return {}; }
  */
 std::array<uint8_t, 16> Session::generateUUID() {
     std::array<uint8_t, 16> u;
-    std::random_device rd;
-    for (auto& b : u) b = static_cast<uint8_t>(rd());
+    if (seeded) for (auto& b : u) b = static_cast<uint8_t>((*seeded)());
+    else {
+        std::random_device rd;
+        for (auto& b : u) b = static_cast<uint8_t>(rd());
+    }
     u[6] = (u[6] & 0x0F) | 0x80;
     u[8] = (u[8] & 0x3F) | 0x80;
     return u;
@@ -0,0 +1,94 @@
+#include "session_cache.h"
+#include "log.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @file    session_cache.cpp
+ * @brief   Implementação do cache de sessão mapeado em memória.
+ */
+
+namespace {
+
+uint64_t wallMs() {
+    using namespace std::chrono;
+    return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+bool SessionCache::open(const char* path, const sockaddr_in& server) {
+    close();
+    int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        SLOW_LOG(Error, Session, "[erro] cache de sessão {}: {}", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && (size_t(st.st_size) >= sizeof(Record) || ftruncate(fd, sizeof(Record)) == 0);
+    void* p = ok ? mmap(nullptr, sizeof(Record), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    [[maybe_unused]] int err = errno; // só lido pelo log (some com LOG=OFF)
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        SLOW_LOG(Error, Session, "[erro] cache de sessão {}: {}", path, strerror(err));
+        return false;
+    }
+    rec = static_cast<Record*>(p);
+    srv = server;
+    if (rec->magic != MAGIC || rec->version != VERSION) {
+        memset(rec, 0, sizeof(Record));
+        rec->magic = MAGIC;
+        rec->version = VERSION;
+    }
+    return true;
+}
+
+void SessionCache::close() {
+    if (rec) munmap(rec, sizeof(Record));
+    rec = nullptr;
+}
+
+bool SessionCache::load(Session& s) const {
+    if (!rec) return false;
+    uint32_t gen = __atomic_load_n(&rec->gen, __ATOMIC_ACQUIRE);
+    if (!rec->valid || (gen & 1)) return false;
+    if (rec->serverIp != srv.sin_addr.s_addr || rec->serverPort != srv.sin_port) return false;
+    if (rec->sttl && wallMs() > rec->savedAt + rec->sttl) return false;
+
+    copy(begin(rec->sid), end(rec->sid), s.sid.begin());
+    s.seqnum = rec->seqnum;
+    s.acknum = rec->acknum;
+    s.sttl = rec->sttl;
+    s.remoteWindow = rec->remoteWindow;
+    s.bytesInFlight = 0;
+    s.connected = false;
+    return true;
+}
+
+void SessionCache::save(const Session& s, uint32_t sentSeq) {
+    if (!rec || s.sid == Session::nilUUID()) return;
+    uint32_t gen = rec->gen | 1;
+    __atomic_store_n(&rec->gen, gen, __ATOMIC_RELEASE);
+    rec->valid = 1;
+    rec->serverIp = srv.sin_addr.s_addr;
+    rec->serverPort = srv.sin_port;
+    rec->recvWindow = s.recvWindow;
+    memcpy(rec->sid, s.sid.data(), sizeof rec->sid);
+    rec->seqnum = int32_t(sentSeq - s.seqnum) > 0 ? sentSeq : s.seqnum;
+    rec->acknum = s.acknum;
+    rec->sttl = s.sttl;
+    rec->remoteWindow = s.remoteWindow;
+    rec->savedAt = wallMs();
+    __atomic_store_n(&rec->gen, gen + 1, __ATOMIC_RELEASE);
+}
+
+void SessionCache::invalidate() {
+    if (rec) rec->valid = 0;
+}
@@ -1,6 +1,7 @@
 #include "session_manager.h"
+#include "log.h"
+#include "metrics.h"
 #include "packet.h"
-#include <iostream>
 using namespace std;
 /**
  * @file    session_manager.cpp
@@ -12,6 +13,91 @@ using namespace std;
  * Logs de diagnóstico são impressos durante os processos para auxiliar na depuração.
  */
 
+/**
+ * @brief Monta o CONNECT inicial com a janela local.
+ */
+SlowPacket makeConnect(const Session& s) {
+    SlowPacket syn;
+    syn.flags = CONNECT;
+    syn.window = s.recvWindow;
+    return syn;
+}
+
+/**
+ * @brief Valida o SETUP (ACCEPT) do servidor e inicializa a sessão.
+ *
+ * @return false se o pacote não trouxer ACCEPT.
+ */
+bool applySetup(const SlowPacketView& setup, Session& s) {
+    if (!(setup.flags & ACCEPT)) return false;
+    copy(setup.sid.begin(), setup.sid.end(), s.sid.begin());
+    s.seqnum = setup.seqnum + 1;
+    s.acknum = setup.seqnum;
+    s.remoteWindow = setup.window;
+    s.bytesInFlight = 0;
+    s.connected = true;
+    s.sttl = setup.sttl;
+    metrics::add(metrics::Counter::Handshakes);
+    return true;
+}
+
+/**
+ * @brief Pure-ACK com o estado corrente da sessão (não consome seqnum).
+ */
+SlowPacket makeAck(const Session& s) {
+    SlowPacket ack;
+    ack.sid = s.sid;
+    ack.flags = ACK;
+    ack.seqnum = s.seqnum;
+    ack.acknum = s.acknum;
+    ack.window = s.recvWindow;
+    ack.sttl = s.sttl;
+    return ack;
+}
+
+/**
+ * @brief Monta o REVIVE | ACK com o UUID da sessão e um payload curto.
+ */
+SlowPacket makeRevive(Session& s, const string& payload) {
+    SlowPacket r;
+    r.sid = s.sid;
+    r.flags = REVIVE | ACK;
+    r.seqnum = ++s.seqnum;
+    r.acknum = s.acknum;
+    r.window = s.recvWindow;
+    r.sttl = s.sttl;
+    r.data.assign(payload.begin(), payload.end());
+    return r;
+}
+
+/**
+ * @brief Aplica a resposta de um revive.
+ *
+ * A resposta válida precisa trazer ACCEPT e ACK; o chamador ainda deve
+ * descartar o que estava em voo (Network::resetFlight).
+ */
+bool applyRevive(const SlowPacketView& resp, Session& s) {
+    if (!(resp.flags & ACCEPT) || !(resp.flags & ACK)) return false;
+    s.acknum = resp.seqnum;
+    s.remoteWindow = resp.window;
+    s.connected = true;
+    s.sttl = resp.sttl;           // espelha STTL mais recente
+    metrics::add(metrics::Counter::Revives);
+    return true;
+}
+
+/**
+ * @brief Monta o pedido de disconnect (CONNECT | REVIVE | ACK).
+ */
+SlowPacket makeDisconnect(Session& s) {
+    SlowPacket disc;
+    disc.sid = s.sid;
+    disc.flags = CONNECT | REVIVE | ACK;
+    disc.seqnum = ++s.seqnum;
+    disc.acknum = s.acknum;
+    return disc;
+}
+
 /**
  * @brief Estabelece uma nova sessão usando o 3-way handshake.
  *
@@ -27,41 +113,20 @@ using namespace std;
 bool doThreeWayHandshake(Network& net, sockaddr_in& srv, Session& s) {
 
     // envia CONNECT com a janela local
-    SlowPacket syn;
-    syn.flags = CONNECT;
-    syn.window = s.recvWindow;
-
     uint32_t dummy;
-    net.sendPacket(srv, syn, dummy, s);
+    net.sendPacket(srv, makeConnect(s), dummy, s);
 
     //aguarda pacote com ACCEPT do servidor
     SlowPacket setup;
     sockaddr_in from{};
-    if (!net.receivePacket(setup, from, s) || !(setup.flags & ACCEPT)) {
-        cerr << "[HANDSHAKE] FAIL – SETUP inválido\n";
+    if (!net.receivePacket(setup, from, s) || !applySetup(setup, s)) {
+        SLOW_LOG(Error, Session, "[HANDSHAKE] FAIL – SETUP inválido");
         return false;
     }
 
-    //inicializa a sessão local com os dados recebidos
-    s.sid = setup.sid;
-    s.seqnum = setup.seqnum + 1;
-    s.acknum = setup.seqnum;
-    s.remoteWindow = setup.window;
-    s.bytesInFlight = 0;
-    s.connected = true;
-    s.sttl = setup.sttl;
-
-    cout << "[HANDSHAKE] concluído! janela=" << s.remoteWindow << " B\n";
-
-    SlowPacket ack;
-    ack.sid = s.sid;
-    ack.flags = ACK;
-    ack.seqnum = s.seqnum;
-    ack.acknum = s.acknum;
-    ack.window = s.recvWindow;
-    ack.sttl = s.sttl;
+    SLOW_LOG(Info, Session, "[HANDSHAKE] concluído! janela={} B", s.remoteWindow);
 
-    net.sendPacket(srv, ack, dummy, s);
+    net.sendPacket(srv, makeAck(s), dummy, s);
     return true;
 }
 
@@ -85,15 +150,8 @@ bool doThreeWayHandshake(Network& net, sockaddr_in& srv, Session& s) {
 bool tryRevive(Network& net, sockaddr_in& srv, Session& s)
 {
     /* -------- envia REVIVE ------------------------------------ */
-    SlowPacket r;
-    r.sid = s.sid;
-    r.flags = REVIVE | ACK;
-    r.seqnum = ++s.seqnum;
-    r.acknum = s.acknum;
-    r.data.assign({'r','e','v','i','v','e'});   // payload opcional
-
     uint32_t dummy;
-    net.sendPacket(srv, r, dummy, s);
+    net.sendPacket(srv, makeRevive(s), dummy, s);
 
     /* -------- aguarda resposta -------------------------------- */
     SlowPacket resp;
@@ -101,18 +159,41 @@ bool tryRevive(Network& net, sockaddr_in& srv, Session& s)
     if (!net.receivePacket(resp, from, s))
         return false;                      // timeout / erro de rede
 
-    /* -------- valida bits ------------------------------------- */
-    bool hasAccept = resp.flags & ACCEPT;
-    bool hasAck = resp.flags & ACK;
-
-    if (!hasAccept || !hasAck)             // precisa dos DOIS bits
+    /* -------- valida bits e atualiza a sessão ----------------- */
+    if (!applyRevive(resp, s))             // precisa dos DOIS bits
         return false;
+    net.resetFlight(s);
+    return true;
+}
 
-    /* -------- atualiza estado da sessão ----------------------- */
-    s.acknum = resp.seqnum;
-    s.remoteWindow = resp.window;
-    s.bytesInFlight = 0;
-    s.connected = true;
-    s.sttl = resp.sttl;           // espelha STTL mais recente
+uint64_t keepAliveDue(const Network& net, const Session& s) {
+    if (!s.sttl || !net.lastHeard()) return TimerWheel::NONE;
+    return net.lastHeard() + s.sttl / 2;
+}
+
+bool presumedExpired(const Network& net, const Session& s, uint64_t now) {
+    return s.sttl && net.lastHeard() && now >= net.lastHeard() + s.sttl;
+}
+
+/**
+ * @brief Mantém uma sessão ociosa viva (versão bloqueante).
+ *
+ * Antes do prazo manda um pure-ACK, que o servidor responde com a
+ * janela corrente; passado o STTL sem notícias, tenta o revive em
+ * segundo plano para que o próximo envio não pague a reconexão.
+ * @return false só se a sessão estiver perdida (revive recusado).
+ */
+bool keepAlive(Network& net, sockaddr_in& srv, Session& s) {
+    if (presumedExpired(net, s, nowMs())) {
+        SLOW_LOG(Info, Session, "[keepalive] STTL vencido, revive em segundo plano");
+        return tryRevive(net, srv, s);
+    }
+    uint32_t dummy;
+    net.sendPacket(srv, makeAck(s), dummy, s);
+    metrics::add(metrics::Counter::KeepAlives);
+    SlowPacket resp;
+    sockaddr_in from{};
+    if (!net.receivePacket(resp, from, s))
+        SLOW_LOG(Debug, Session, "[keepalive] sem resposta, nova tentativa antes do STTL");
     return true;
 }
@@ -0,0 +1,125 @@
+#include "simulator.h"
+#include "network.h"
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+/**
+ * @file    simulator.cpp
+ * @brief   Implementação do relógio virtual e das pontas simuladas.
+ *
+ * Cada passo escolhe o menor entre: próxima saída de algum enlace,
+ * deadline de algum nó e evento agendado. O relógio salta para lá, as
+ * entregas vencidas vão para as caixas de entrada, os eventos rodam e
+ * todos os nós são chamados. Não há threads nem tempo real envolvido.
+ */
+
+Simulator* Simulator::current = nullptr;
+
+SimTransport::SimTransport(Simulator& s, const sockaddr_in& a, const ImpairedLink::Config& cfg, uint64_t seed)
+: sim(s), addr(a), out(cfg, seed) {}
+
+size_t SimTransport::send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) {
+    for (size_t i = 0; i < n; ++i) out.admit(to, dgrams[i].iov, 2, sim.nowUs());
+    return n;
+}
+
+size_t SimTransport::recv(Datagram* dst, size_t max) {
+    for (auto& b : delivered) out.recycle(std::move(b));
+    delivered.clear();
+    size_t got = 0;
+    for (; got < max && !inbox.empty(); ++got) {
+        delivered.push_back(std::move(inbox.front().bytes));
+        dst[got].data = delivered.back().data();
+        dst[got].len = delivered.back().size();
+        dst[got].from = inbox.front().addr;
+        inbox.pop_front();
+    }
+    return got;
+}
+
+Simulator::Simulator(uint64_t s) : seed(s) {
+    assert(!current);
+    current = this;
+    nowMsHook = &Simulator::clock;
+}
+
+Simulator::~Simulator() {
+    nowMsHook = nullptr;
+    current = nullptr;
+}
+
+uint64_t Simulator::clock() { return current->nowMs(); }
+
+shared_ptr<SimTransport> Simulator::endpoint(const sockaddr_in& addr, const ImpairedLink::Config& out) {
+    // cada enlace tem sua semente, derivada da global e da ordem de criação
+    eps.push_back(make_shared<SimTransport>(*this, addr, out, seed * 0x9e3779b97f4a7c15ULL + eps.size()));
+    return eps.back();
+}
+
+void Simulator::addNode(function<uint64_t()> deadline, function<void()> poll) {
+    nodes.push_back({std::move(deadline), std::move(poll)});
+}
+
+void Simulator::at(uint64_t ms, function<void()> fn) {
+    timers.push_back({max(ms * 1000, now), order++, std::move(fn)});
+    push_heap(timers.begin(), timers.end(), Later());
+}
+
+SimTransport* Simulator::find(const sockaddr_in& a) const {
+    for (auto& e : eps)
+        if (e->addr.sin_addr.s_addr == a.sin_addr.s_addr && e->addr.sin_port == a.sin_port) return e.get();
+    return nullptr;
+}
+
+uint64_t Simulator::nextEvent() const {
+    uint64_t next = timers.empty() ? NONE : timers.front().when;
+    for (auto& e : eps) next = min(next, e->out.nextDue());
+    for (auto& n : nodes) {
+        uint64_t d = n.deadline();
+        if (d != NONE) next = min(next, d * 1000);
+    }
+    return next;
+}
+
+/**
+ * @brief Move para o destino tudo o que já atravessou os enlaces.
+ *
+ * Um datagrama para endereço sem ponta some, como num UDP de verdade.
+ */
+void Simulator::deliver() {
+    for (auto& e : eps)
+        while (e->out.due(now)) {
+            ImpairedLink::Packet p = e->out.pop();
+            SimTransport* dst = find(p.addr);
+            if (!dst) { e->out.recycle(std::move(p.bytes)); continue; }
+            p.addr = e->addr;
+            dst->inbox.push_back(std::move(p));
+        }
+}
+
+bool Simulator::runUntil(uint64_t ms) {
+    uint64_t end = ms * 1000;
+    int stuck = 0;
+    for (;;) {
+        uint64_t next = nextEvent();
+        if (next == NONE || next > end) {
+            now = max(now, end);
+            return next != NONE;
+        }
+        // um nó que não consome o próprio deadline não pode congelar o relógio
+        if (next <= now) { if (++stuck > 64) { next = now + 1000; stuck = 0; } }
+        else stuck = 0;
+        now = max(now, next);
+        ++steps;
+
+        deliver();
+        while (!timers.empty() && timers.front().when <= now) {
+            pop_heap(timers.begin(), timers.end(), Later());
+            function<void()> fn = std::move(timers.back().fn);
+            timers.pop_back();
+            fn();
+        }
+        for (auto& n : nodes) n.poll();
+    }
+}
@@ -0,0 +1,63 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+/**
+ * @file    timer_wheel.cpp
+ * @brief   Implementação da roda de temporizadores.
+ *
+ * Um deadline cai no slot `(deadline / tickMs) % slots`. Entradas que
+ * ficam a mais de uma volta de distância permanecem no slot e só são
+ * liberadas quando o relógio de fato as alcança.
+ */
+
+TimerWheel::TimerWheel(uint64_t t, size_t slots) : wheel(slots), tickMs(t ? t : 1) {}
+
+void TimerWheel::schedule(uint32_t key, uint64_t deadline) {
+    uint64_t tick = std::max(deadline / tickMs, cur);
+    wheel[tick % wheel.size()].push_back({key, deadline});
+    ++count;
+    if (!stale) earliest = std::min(earliest, deadline);
+}
+
+void TimerWheel::expire(uint64_t now, std::vector<uint32_t>& out) {
+    uint64_t nowTick = now / tickMs;
+    if (nowTick < cur) return;
+    if (count == 0) { cur = nowTick; return; }
+
+    uint64_t steps = std::min<uint64_t>(nowTick - cur, wheel.size() - 1);
+    for (uint64_t t = nowTick - steps; t <= nowTick; ++t) {
+        auto& slot = wheel[t % wheel.size()];
+        auto keep = slot.begin();
+        for (auto& e : slot) {
+            if (e.deadline <= now) { out.push_back(e.key); --count; stale = true; }
+            else *keep++ = e;
+        }
+        slot.erase(keep, slot.end());
+    }
+    cur = nowTick;
+}
+
+uint64_t TimerWheel::nextDeadline() const {
+    if (count == 0) return NONE;
+    if (!stale) return earliest;
+    stale = false;
+    uint64_t best = NONE;
+    // percorre uma volta a partir do tick atual; o primeiro slot com
+    // entrada desta volta contém o menor deadline
+    for (size_t i = 0; i < wheel.size(); ++i) {
+        for (auto& e : wheel[(cur + i) % wheel.size()])
+            if (e.deadline / tickMs <= cur + i) best = std::min(best, e.deadline);
+        if (best != NONE) return earliest = best;
+    }
+    // tudo está a mais de uma volta: varredura completa
+    for (auto& slot : wheel)
+        for (auto& e : slot) best = std::min(best, e.deadline);
+    return earliest = best;
+}
+
+void TimerWheel::clear() {
+    for (auto& slot : wheel) slot.clear();
+    count = 0;
+    earliest = NONE;
+    stale = false;
+}
@@ -0,0 +1,268 @@
+#include "transport.h"
+#include "log.h"
+#include "slow.h"
+#ifdef SLOW_WITH_URING
+#include "uring_transport.h"
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/udp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+using namespace std;
+
+/**
+ * @file    transport.cpp
+ * @brief   Backend UDP padrão (select + sendmmsg/recvmmsg, GSO/GRO opcional).
+ *
+ * Fora do Linux o envio e a recepção em lote caem em um sendto/recvfrom
+ * por datagrama.
+ */
+
+bool Transport::bind(const sockaddr_in& local) {
+    int one = 1;
+    setsockopt(fd(), SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    return ::bind(fd(), reinterpret_cast<const sockaddr*>(&local), sizeof local) == 0;
+}
+
+UdpTransport::UdpTransport() : rxBuf(BATCH * MAX_PACKET) {}
+
+bool UdpTransport::open() {
+    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    return sockfd >= 0;
+}
+
+void UdpTransport::close() {
+    if (sockfd >= 0) ::close(sockfd);
+    sockfd = -1;
+}
+
+size_t UdpTransport::send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) {
+    size_t sent = gso ? sendOffload(to, dgrams, n) : 0;
+#ifdef __linux__
+    mmsghdr msgs[BATCH];
+    while (sent < n) {
+        size_t cnt = min(n - sent, BATCH);
+        for (size_t i = 0; i < cnt; ++i) {
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(&to);
+            msgs[i].msg_hdr.msg_namelen = sizeof(to);
+            msgs[i].msg_hdr.msg_iov = const_cast<iovec*>(dgrams[sent + i].iov);
+            msgs[i].msg_hdr.msg_iovlen = 2;
+        }
+        int r = ::sendmmsg(sockfd, msgs, cnt, 0);
+        if (r < 0) { if (errno == EINTR) continue; break; }
+        sent += r;
+        if (size_t(r) < cnt) break;
+    }
+#else
+    for (; sent < n; ++sent) {
+        msghdr mh{};
+        mh.msg_name = const_cast<sockaddr_in*>(&to);
+        mh.msg_namelen = sizeof(to);
+        mh.msg_iov = const_cast<iovec*>(dgrams[sent].iov);
+        mh.msg_iovlen = 2;
+        ssize_t r = ::sendmsg(sockfd, &mh, 0);
+        if (r != static_cast<ssize_t>(dgrams[sent].size())) break;
+    }
+#endif
+    return sent;
+}
+
+bool UdpTransport::wait(uint64_t timeoutMs) {
+    if (groOff < groLen) return true;   // segmentos GRO ainda não entregues
+    timeval tv{time_t(timeoutMs / 1000), suseconds_t(timeoutMs % 1000 * 1000)};
+    fd_set rf; FD_ZERO(&rf); FD_SET(sockfd, &rf);
+    return select(sockfd + 1, &rf, nullptr, nullptr, &tv) > 0;
+}
+
+size_t UdpTransport::recv(Datagram* out, size_t max) {
+    max = min(max, BATCH);
+    if (gro) return recvGro(out, max);
+    size_t got = 0;
+#ifdef __linux__
+    mmsghdr msgs[BATCH]; iovec iov[BATCH];
+    for (size_t i = 0; i < max; ++i) {
+        iov[i] = {rxBuf.data() + i * MAX_PACKET, size_t(MAX_PACKET)};
+        msgs[i] = {};
+        msgs[i].msg_hdr.msg_name = &out[i].from;
+        msgs[i].msg_hdr.msg_namelen = sizeof(out[i].from);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int r;
+    do r = ::recvmmsg(sockfd, msgs, max, MSG_DONTWAIT, nullptr);
+    while (r < 0 && errno == EINTR);
+    for (int i = 0; i < r; ++i) {
+        out[i].data = rxBuf.data() + i * MAX_PACKET;
+        out[i].len = msgs[i].msg_len;
+    }
+    got = r > 0 ? size_t(r) : 0;
+#else
+    for (; got < max; ++got) {
+        socklen_t alen = sizeof(out[got].from);
+        uint8_t* buf = rxBuf.data() + got * MAX_PACKET;
+        ssize_t n = recvfrom(sockfd, buf, MAX_PACKET, MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&out[got].from), &alen);
+        if (n < 0) break;
+        out[got].data = buf;
+        out[got].len = size_t(n);
+    }
+#endif
+    return got;
+}
+
+bool UdpTransport::enableOffload() {
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    int seg = MAX_PACKET;
+    gso = setsockopt(sockfd, SOL_UDP, UDP_SEGMENT, &seg, sizeof(seg)) == 0;
+    // o tamanho real vai por cmsg a cada envio; zera o padrão do socket
+    seg = 0;
+    if (gso) setsockopt(sockfd, SOL_UDP, UDP_SEGMENT, &seg, sizeof(seg));
+#endif
+#if defined(__linux__) && defined(UDP_GRO)
+    int on = 1;
+    gro = setsockopt(sockfd, SOL_UDP, UDP_GRO, &on, sizeof(on)) == 0;
+    if (gro) groBuf.resize(UINT16_MAX);
+#endif
+    return gso;
+}
+
+/**
+ * @brief Envia o prefixo do lote em super-datagramas segmentados pelo kernel.
+ *
+ * Cada sendmsg junta (via iovec, sem cópia extra) uma sequência de
+ * datagramas do mesmo tamanho, opcionalmente terminada por um menor, e
+ * informa o tamanho do segmento em um cmsg UDP_SEGMENT; os pares
+ * cabeçalho/payload viram uma única lista de iovecs, já que o kernel
+ * corta os segmentos só pelo tamanho. Em erro o GSO é desligado e o
+ * restante segue pelo caminho normal.
+ *
+ * @return quantos datagramas do início do lote foram enviados.
+ */
+size_t UdpTransport::sendOffload(const sockaddr_in& to, const OutDatagram* dgrams, size_t cnt) {
+    size_t sent = 0;
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(uint16_t))];
+    iovec iov[2 * GSO_MAX_SEGS];
+    while (sent < cnt) {
+        size_t segLen = dgrams[sent].size(), n = 0, bytes = 0;
+        while (sent + n < cnt && n < GSO_MAX_SEGS && bytes + dgrams[sent + n].size() <= GSO_MAX_BYTES) {
+            size_t l = dgrams[sent + n].size();
+            if (l > segLen) break;
+            iov[2 * n] = dgrams[sent + n].iov[0];
+            iov[2 * n + 1] = dgrams[sent + n].iov[1];
+            bytes += l; ++n;
+            if (l < segLen) break;   // só o último pode ser menor
+        }
+        if (n < 2) break;            // nada a ganhar: caminho normal
+
+        msghdr mh{};
+        mh.msg_name = const_cast<sockaddr_in*>(&to);
+        mh.msg_namelen = sizeof(to);
+        mh.msg_iov = iov;
+        mh.msg_iovlen = 2 * n;
+        mh.msg_control = ctrl;
+        mh.msg_controllen = sizeof(ctrl);
+        cmsghdr* cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t gsoSize = uint16_t(segLen);
+        memcpy(CMSG_DATA(cm), &gsoSize, sizeof(gsoSize));
+
+        ssize_t r;
+        do r = ::sendmsg(sockfd, &mh, 0);
+        while (r < 0 && errno == EINTR);
+        if (r < 0) {
+            SLOW_LOG(Warn, Io, "[gso] envio segmentado falhou, voltando ao caminho normal");
+            gso = false;
+            break;
+        }
+        sent += n;
+    }
+#else
+    (void)to; (void)dgrams; (void)cnt;
+#endif
+    return sent;
+}
+
+/**
+ * @brief Recepção com UDP_GRO: lê datagramas possivelmente coalescidos
+ *        e os divide pelo tamanho de segmento informado no cmsg.
+ *
+ * Segmentos que não couberem em `out` ficam guardados para a próxima
+ * chamada (wait() os considera legíveis).
+ */
+size_t UdpTransport::recvGro(Datagram* out, size_t max) {
+    size_t got = 0;
+    auto drain = [&] {
+        while (got < max && groOff < groLen) {
+            size_t n = min(groSeg, groLen - groOff);
+            out[got++] = {groBuf.data() + groOff, n, groFrom};
+            groOff += n;
+        }
+    };
+    drain();
+#if defined(__linux__) && defined(UDP_GRO)
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))];
+    // só lê um novo datagrama quando o corrente foi todo entregue, pois
+    // `out` aponta para dentro de groBuf
+    while (got == 0) {
+        iovec iov{groBuf.data(), groBuf.size()};
+        msghdr mh{};
+        mh.msg_name = &groFrom;
+        mh.msg_namelen = sizeof(groFrom);
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = ctrl;
+        mh.msg_controllen = sizeof(ctrl);
+        ssize_t n = ::recvmsg(sockfd, &mh, MSG_DONTWAIT);
+        if (n < 0) { if (errno == EINTR) continue; break; }
+
+        groLen = size_t(n); groOff = 0; groSeg = groLen;
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+            if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+                int seg; memcpy(&seg, CMSG_DATA(cm), sizeof(seg));
+                if (seg > 0) groSeg = size_t(seg);
+            }
+        }
+        if (!groSeg) { groLen = 0; continue; }
+        drain();
+    }
+#endif
+    return got;
+}
+
+bool parseAddress(const string& s, sockaddr_in& out, uint16_t port) {
+    size_t colon = s.rfind(':');
+    if (colon != string::npos) {
+        char* end;
+        unsigned long p = strtoul(s.c_str() + colon + 1, &end, 10);
+        if (*end || !p || p > UINT16_MAX) return false;
+        port = uint16_t(p);
+    }
+    out = sockaddr_in{};
+    out.sin_family = AF_INET;
+    out.sin_port = htons(port);
+    return inet_pton(AF_INET, s.substr(0, colon).c_str(), &out.sin_addr) == 1;
+}
+
+vector<string> transportNames() {
+#ifdef SLOW_WITH_URING
+    return {"socket", "uring"};
+#else
+    return {"socket"};
+#endif
+}
+
+unique_ptr<Transport> makeTransport(const string& name) {
+    if (name == "socket" || name == "select") return make_unique<UdpTransport>();
+#ifdef SLOW_WITH_URING
+    if (name == "uring" || name == "io_uring") return make_unique<UringTransport>();
+#endif
+    return nullptr;
+}
@@ -0,0 +1,270 @@
+#include "uring_transport.h"
+
+/**
+ * @file    uring_transport.cpp
+ * @brief   Implementação do backend io_uring.
+ *
+ * Ciclo de vida da recepção: um único SQE RECVMSG multishot escolhe
+ * buffers do grupo BGID; cada CQE vira uma entrada em `ready` até ser
+ * entregue por recv(), e o buffer é devolvido ao grupo (um SQE
+ * PROVIDE_BUFFERS, sem syscall própria) na chamada seguinte.
+ * Se o kernel encerrar o multishot (sem IORING_CQE_F_MORE, por exemplo
+ * por falta de buffers), ele é re-armado.
+ */
+
+#ifdef SLOW_WITH_URING
+
+#include "slow.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+using namespace std;
+
+template <typename T> static T loadAcquire(const T* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+template <typename T> static void storeRelease(T* p, T v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+bool UringTransport::open() {
+    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) return false;
+
+    io_uring_params p{};
+    ringfd = int(syscall(__NR_io_uring_setup, ENTRIES, &p));
+    if (ringfd < 0 || !(p.features & IORING_FEAT_SINGLE_MMAP)) { close(); return false; }
+
+    sqEntries = p.sq_entries;
+    sqMapSz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqMapSz = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    sqMapSz = cqMapSz = max(sqMapSz, cqMapSz);
+    sqMap = mmap(nullptr, sqMapSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQ_RING);
+    if (sqMap == MAP_FAILED) { sqMap = nullptr; close(); return false; }
+    cqMap = sqMap;
+    sqesSz = p.sq_entries * sizeof(io_uring_sqe);
+    void* s = mmap(nullptr, sqesSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQES);
+    if (s == MAP_FAILED) { close(); return false; }
+    sqes = static_cast<io_uring_sqe*>(s);
+
+    auto* sq = static_cast<uint8_t*>(sqMap);
+    sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(sq + p.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(sq + p.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(sq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(sq + p.cq_off.cqes);
+
+    // memória dos buffers, entregue ao kernel de uma vez
+    void* m = mmap(nullptr, size_t(NBUFS) * BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) { close(); return false; }
+    bufMem = static_cast<uint8_t*>(m);
+    if (!provide(0, NBUFS) || enter(0, 0) < 0) { close(); return false; }
+
+    ready.reserve(NBUFS);
+    lent.reserve(NBUFS);
+    return true;
+}
+
+void UringTransport::close() {
+    if (sqes) munmap(sqes, sqesSz);
+    if (sqMap) munmap(sqMap, sqMapSz);
+    if (bufMem) munmap(bufMem, size_t(NBUFS) * BUF_SIZE);
+    sqes = nullptr; sqMap = cqMap = nullptr; bufMem = nullptr;
+    if (ringfd >= 0) ::close(ringfd);
+    if (sockfd >= 0) ::close(sockfd);
+    ringfd = sockfd = -1;
+    recvArmed = false;
+    ready.clear(); readyHead = 0; lent.clear();
+}
+
+/**
+ * @brief Próximo SQE livre; submete o que estiver pendente se o SQ encheu.
+ */
+io_uring_sqe* UringTransport::getSqe() {
+    unsigned tail = *sqTail;
+    if (tail - loadAcquire(sqHead) >= sqEntries) {
+        enter(0, 0);
+        if (tail - loadAcquire(sqHead) >= sqEntries) return nullptr;
+    }
+    unsigned idx = tail & *sqMask;
+    sqArray[idx] = idx;
+    io_uring_sqe* sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    storeRelease(sqTail, tail + 1);
+    ++toSubmit;
+    return sqe;
+}
+
+int UringTransport::enter(unsigned minComplete, unsigned flags) {
+    int r;
+    do r = int(syscall(__NR_io_uring_enter, ringfd, toSubmit, minComplete, flags, nullptr, 0));
+    while (r < 0 && errno == EINTR);
+    if (r >= 0) toSubmit -= min<unsigned>(toSubmit, unsigned(r));
+    return r;
+}
+
+/**
+ * @brief Enfileira um SQE que devolve `count` buffers a partir de `bid`
+ *        ao grupo BGID (submetido junto com a próxima io_uring_enter).
+ */
+bool UringTransport::provide(uint16_t bid, unsigned count) {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = int(count);
+    sqe->addr = reinterpret_cast<uint64_t>(bufMem + size_t(bid) * BUF_SIZE);
+    sqe->len = BUF_SIZE;
+    sqe->off = bid;
+    sqe->buf_group = BGID;
+    sqe->user_data = TAG_PROVIDE;
+    return true;
+}
+
+void UringTransport::armRecv() {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return;
+    recvHdr = {};
+    recvHdr.msg_namelen = sizeof(sockaddr_in);
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = sockfd;
+    sqe->addr = reinterpret_cast<uint64_t>(&recvHdr);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BGID;
+    sqe->user_data = TAG_RECV;
+    recvArmed = true;
+}
+
+/**
+ * @brief Converte um CQE de recepção em entrada de `ready`.
+ *
+ * Layout do buffer: io_uring_recvmsg_out, nome (msg_namelen bytes),
+ * controle (vazio) e payload.
+ */
+void UringTransport::onRecv(const io_uring_cqe& cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) recvArmed = false;
+    if (cqe.res < 0 || !(cqe.flags & IORING_CQE_F_BUFFER)) return;
+
+    uint16_t bid = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    const uint8_t* base = bufMem + size_t(bid) * BUF_SIZE;
+    io_uring_recvmsg_out out;
+    memcpy(&out, base, sizeof(out));
+    const uint8_t* name = base + sizeof(out);
+    const uint8_t* payload = name + recvHdr.msg_namelen + recvHdr.msg_controllen;
+    size_t avail = size_t(cqe.res) - (payload - base);
+
+    Ready r{bid, {}};
+    r.dg.data = payload;
+    r.dg.len = min<size_t>(out.payloadlen, avail);
+    memcpy(&r.dg.from, name, min<size_t>(out.namelen, sizeof(r.dg.from)));
+    ready.push_back(r);
+}
+
+/**
+ * @brief Consome todos os CQEs disponíveis.
+ * @return quantidade de CQEs processados.
+ */
+size_t UringTransport::reap(unsigned* sends, unsigned* sendOk) {
+    unsigned head = *cqHead, tail = loadAcquire(cqTail);
+    size_t n = 0;
+    for (; head != tail; ++head, ++n) {
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        if (cqe.user_data == TAG_RECV) onRecv(cqe);
+        else if (cqe.user_data == TAG_SEND && sends) {
+            ++*sends;
+            if (cqe.res >= 0 && sendOk) ++*sendOk;
+        }
+    }
+    storeRelease(cqHead, head);
+    return n;
+}
+
+/**
+ * @brief Um SENDMSG por datagrama, todos submetidos numa única
+ *        io_uring_enter que também espera suas conclusões.
+ *
+ * Os SQEs são encadeados (IOSQE_IO_LINK) para preservar a ordem dos
+ * seqnums no fio.
+ */
+size_t UringTransport::send(const sockaddr_in& to, const OutDatagram* dgrams, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        size_t cnt = min<size_t>(n - done, sqEntries / 2);
+        sendHdrs.assign(cnt, msghdr{});
+        size_t queued = 0;
+        for (; queued < cnt; ++queued) {
+            io_uring_sqe* sqe = getSqe();
+            if (!sqe) break;
+            msghdr& mh = sendHdrs[queued];
+            mh.msg_name = const_cast<sockaddr_in*>(&to);
+            mh.msg_namelen = sizeof(to);
+            mh.msg_iov = const_cast<iovec*>(dgrams[done + queued].iov);
+            mh.msg_iovlen = 2;
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = sockfd;
+            sqe->addr = reinterpret_cast<uint64_t>(&mh);
+            sqe->len = 1;
+            sqe->user_data = TAG_SEND;
+            if (queued + 1 < cnt) sqe->flags = IOSQE_IO_LINK;
+        }
+        if (!queued) break;
+        unsigned seen = 0, ok = 0;
+        if (enter(unsigned(queued), IORING_ENTER_GETEVENTS) < 0) break;
+        reap(&seen, &ok);
+        while (seen < queued) {
+            if (enter(1, IORING_ENTER_GETEVENTS) < 0) break;
+            reap(&seen, &ok);
+        }
+        done += ok;
+        if (ok < queued) break;
+    }
+    return done;
+}
+
+/**
+ * @brief Espera um datagrama com um SQE IORING_OP_TIMEOUT.
+ *
+ * O timeout é do tipo "count = 1": completa no primeiro CQE que chegar
+ * ou quando o prazo vence, o que vier antes.
+ */
+bool UringTransport::wait(uint64_t timeoutMs) {
+    if (!recvArmed) armRecv();
+    reap();
+    if (readyHead < ready.size()) return true;
+
+    ts.tv_sec = int64_t(timeoutMs / 1000);
+    ts.tv_nsec = int64_t(timeoutMs % 1000) * 1000000;
+    if (io_uring_sqe* sqe = getSqe()) {
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->addr = reinterpret_cast<uint64_t>(&ts);
+        sqe->len = 1;
+        sqe->off = 1;
+        sqe->user_data = TAG_TIMEOUT;
+    }
+    enter(1, IORING_ENTER_GETEVENTS);
+    reap();
+    return readyHead < ready.size();
+}
+
+size_t UringTransport::recv(Datagram* out, size_t max) {
+    // buffers entregues na chamada anterior voltam ao grupo
+    for (uint16_t b : lent) provide(b, 1);
+    lent.clear();
+    if (readyHead == ready.size()) {
+        ready.clear(); readyHead = 0;
+        if (!recvArmed) armRecv();
+        if (toSubmit) enter(0, 0);
+        reap();
+    }
+    size_t got = 0;
+    while (got < max && readyHead < ready.size()) {
+        lent.push_back(ready[readyHead].bid);
+        out[got++] = ready[readyHead++].dg;
+    }
+    return got;
+}
+
+#endif
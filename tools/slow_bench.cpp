@@ -0,0 +1,367 @@
+#include "log.h"
+#include "network.h"
+#include "packet.h"
+#include "session.h"
+#include "transport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+using namespace std;
+
+/**
+ * @file    slow_bench.cpp
+ * @brief   Micro-benchmarks do codec, do log e da fila de retransmissão.
+ *
+ * Uso: slow_bench [--filter=texto] [--min-time=ms] [--json]
+ *
+ * Cada caso é calibrado até somar `min-time` e medido REPEATS vezes; sai
+ * a mediana de ns/op e as alocações por operação da thread do benchmark
+ * (operator new contado). A saída é uma linha por caso, em colunas
+ * separadas por espaço (ou JSON por linha com --json).
+ */
+
+/* ───────── contagem de alocações (só da thread do benchmark) ───────── */
+static thread_local uint64_t allocCount = 0;
+
+void* operator new(size_t n) {
+    ++allocCount;
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+constexpr int REPEATS = 5;
+
+/**
+ * @brief Impede o compilador de descartar um resultado.
+ */
+template <typename T>
+inline void keep(const T& v) { asm volatile("" : : "r,m"(v) : "memory"); }
+
+/**
+ * @brief Contexto de uma medição: `iters` operações; pause()/resume()
+ *        tiram trechos de preparação do tempo.
+ */
+struct State {
+    uint64_t iters;
+    Clock::duration paused{};
+    Clock::time_point mark;
+    void pause() { mark = Clock::now(); }
+    void resume() { paused += Clock::now() - mark; }
+};
+
+struct Result {
+    string name;
+    uint64_t iters;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+using Body = function<void(State&)>;
+
+double measure(const Body& body, uint64_t iters, uint64_t& allocs) {
+    State st{iters, {}, {}};
+    uint64_t a0 = allocCount;
+    auto t0 = Clock::now();
+    body(st);
+    auto el = Clock::now() - t0 - st.paused;
+    allocs = allocCount - a0;
+    return double(chrono::duration_cast<chrono::nanoseconds>(el).count()) / double(iters);
+}
+
+Result run(const string& name, const Body& body, uint64_t minTimeNs) {
+    // calibra: dobra até uma rodada levar ~min-time/REPEATS
+    uint64_t iters = 1, allocs;
+    uint64_t target = minTimeNs / REPEATS;
+    while (true) {
+        double ns = measure(body, iters, allocs);
+        if (ns * double(iters) >= double(target) || iters >= (1ull << 32)) break;
+        uint64_t guess = ns > 0 ? uint64_t(double(target) / ns * 1.2) : iters * 10;
+        iters = max(iters * 2, min(guess, iters * 100));
+    }
+    vector<double> ns(REPEATS);
+    uint64_t totalAllocs = 0;
+    for (double& v : ns) { v = measure(body, iters, allocs); totalAllocs += allocs; }
+    sort(ns.begin(), ns.end());
+    return {name, iters, ns[REPEATS / 2], double(totalAllocs) / double(iters * REPEATS)};
+}
+
+/* ───────── casos ───────── */
+
+SlowPacket samplePacket(size_t len) {
+    SlowPacket p;
+    p.sid = Session::generateUUID();
+    p.flags = ACK | MOREBITS;
+    p.sttl = 599;
+    p.seqnum = 123456;
+    p.acknum = 654321;
+    p.window = 7200;
+    p.fid = 7;
+    p.fo = 3;
+    p.data.assign(len, 'x');
+    return p;
+}
+
+void benchSerialize(State& st, size_t len) {
+    SlowPacket p = samplePacket(len);
+    uint8_t buf[MAX_PACKET];
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        size_t n;
+        p.serialize(buf, n);
+        keep(buf[0]);
+    }
+}
+
+void benchDeserialize(State& st, size_t len) {
+    SlowPacket src = samplePacket(len), p;
+    uint8_t buf[MAX_PACKET];
+    size_t n;
+    src.serialize(buf, n);
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        p.deserialize(buf, n);
+        keep(p.seqnum);
+    }
+}
+
+void benchParse(State& st, size_t len) {
+    SlowPacket src = samplePacket(len);
+    uint8_t buf[MAX_PACKET];
+    size_t n;
+    src.serialize(buf, n);
+    SlowPacketView v;
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        keep(v.parse(buf, n));
+        keep(v.seqnum);
+    }
+}
+
+void benchPackLE(State& st) {
+    uint8_t buf[4];
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        packLE(buf, uint32_t(i), 4);
+        keep(buf);
+    }
+}
+
+void benchUnpackLE(State& st) {
+    uint8_t buf[4] = {1, 2, 3, 4};
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        keep(unpackLE(buf, 4));
+        keep(buf);
+    }
+}
+
+void benchFlags(State& st, bool longNames) {
+    uint8_t f = CONNECT | REVIVE | ACK;
+    for (uint64_t i = 0; i < st.iters; ++i) keep(flagsToString(f, longNames).size());
+}
+
+/**
+ * @brief Descarta tudo: mede a formatação, não o terminal.
+ */
+class NullBuf : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+/**
+ * @brief Sink que só conta, para medir o produtor do log.
+ */
+class NullSink : public slowlog::Sink {
+public:
+    void write(const slowlog::Record&) override {}
+};
+
+/**
+ * @brief Custo de quem loga: registro na fila (a thread de fundo
+ *        consome fora da medição, a cada RING/4 registros).
+ */
+void benchLogEnqueue(State& st) {
+    SlowPacket p = samplePacket(1440);
+    SlowPacketView v(p);
+    slowlog::setLevel(slowlog::Cat::Packet, slowlog::Level::Trace);
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        SLOW_LOG_PACKET(Debug, "TX", v);
+        if ((i & 1023) == 1023) { st.pause(); slowlog::flush(); st.resume(); }
+    }
+    st.pause();
+    slowlog::flush();
+    slowlog::setLevel(slowlog::Level::Off);
+    st.resume();
+}
+
+/**
+ * @brief Chamada de log com a categoria desligada em tempo de execução.
+ */
+void benchLogFiltered(State& st) {
+    SlowPacket p = samplePacket(1440);
+    SlowPacketView v(p);
+    for (uint64_t i = 0; i < st.iters; ++i) {
+        SLOW_LOG_PACKET(Debug, "TX", v);
+        keep(i);
+    }
+}
+
+/**
+ * @brief Formatação em caixa de um pacote (o antigo logPacket), feita
+ *        pela thread de fundo.
+ */
+void benchLogBox(State& st) {
+    NullBuf nb;
+    ostream out(&nb);
+    auto sink = slowlog::makeBoxSink(out, out);
+    slowlog::Record r{};
+    r.fmt = "TX";
+    r.level = slowlog::Level::Debug;
+    r.cat = slowlog::Cat::Packet;
+    r.packet = true;
+    SlowPacket p = samplePacket(1440);
+    copy(p.sid.begin(), p.sid.end(), r.hdr.sid);
+    r.hdr.flags = p.flags;
+    r.hdr.seqnum = p.seqnum;
+    r.hdr.acknum = p.acknum;
+    r.hdr.window = p.window;
+    r.hdr.dataLen = uint16_t(p.data.size());
+    r.textLen = 50;
+    memset(r.text, 'x', r.textLen);
+    for (uint64_t i = 0; i < st.iters; ++i) sink->write(r);
+}
+
+/**
+ * @brief Backend que aceita tudo e não entrega nada.
+ */
+class NullTransport : public Transport {
+public:
+    const char* name() const override { return "null"; }
+    bool open() override { return true; }
+    void close() override {}
+    size_t send(const sockaddr_in&, const OutDatagram*, size_t n) override { return n; }
+    bool wait(uint64_t) override { return false; }
+    size_t recv(Datagram*, size_t) override { return 0; }
+    int fd() const override { return -1; }
+};
+
+/**
+ * @brief Uma operação = um envio (pushPending) e o ACK cumulativo do
+ *        pendente mais antigo (dropAcked), com `depth` pacotes em voo.
+ */
+void benchSendAck(State& st, size_t depth) {
+    st.pause();
+    Network net;
+    net.attach(make_shared<NullTransport>());
+    Session sess;
+    sess.sid = Session::generateUUID();
+    sess.remoteWindow = UINT16_MAX;
+    sockaddr_in dst{};
+    dst.sin_family = AF_INET;
+
+    uint8_t payload[16] = {};
+    SlowPacketView d;
+    d.sid = ByteSpan(sess.sid.data(), sess.sid.size());
+    d.flags = ACK;
+    d.data = ByteSpan(payload, sizeof payload);
+
+    uint8_t ackBuf[HDR_SIZE];
+    SlowPacketView a;
+    a.sid = d.sid;
+    a.flags = ACK;
+    a.window = UINT16_MAX;
+    Datagram dg;
+    dg.data = ackBuf;
+    dg.len = HDR_SIZE;
+    SlowPacketView parsed;
+
+    uint32_t seq = 1, last;
+    for (; seq <= depth; ++seq) { d.seqnum = seq; net.sendPacket(dst, d, last, sess); }
+    st.resume();
+
+    for (uint64_t i = 0; i < st.iters; ++i, ++seq) {
+        d.seqnum = seq;
+        net.sendPacket(dst, d, last, sess);
+        a.seqnum = a.acknum = seq - uint32_t(depth);
+        a.serializeHeader(ackBuf);
+        net.onDatagram(dg, parsed, sess);
+        // a roda de RTO só esvazia quando expira
+        if ((i & 4095) == 4095) { st.pause(); net.onTimer(sess); st.resume(); }
+    }
+    keep(net.pendingCount());
+}
+
+struct Case {
+    string name;
+    Body body;
+};
+
+vector<Case> cases() {
+    vector<Case> v;
+    for (size_t len : {size_t(0), size_t(MAX_DATA)}) {
+        string s = "/" + to_string(len);
+        v.push_back({"packet.serialize" + s, [len](State& st) { benchSerialize(st, len); }});
+        v.push_back({"packet.deserialize" + s, [len](State& st) { benchDeserialize(st, len); }});
+        v.push_back({"view.parse" + s, [len](State& st) { benchParse(st, len); }});
+    }
+    v.push_back({"packLE/4", benchPackLE});
+    v.push_back({"unpackLE/4", benchUnpackLE});
+    v.push_back({"flagsToString/long", [](State& st) { benchFlags(st, true); }});
+    v.push_back({"flagsToString/short", [](State& st) { benchFlags(st, false); }});
+    v.push_back({"log.packet/enqueue", benchLogEnqueue});
+    v.push_back({"log.packet/filtered", benchLogFiltered});
+    v.push_back({"log.packet/box", benchLogBox});
+    for (size_t depth : {1, 8, 32})
+        v.push_back({"network.send_ack/depth=" + to_string(depth),
+                     [depth](State& st) { benchSendAck(st, depth); }});
+    return v;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string filter;
+    uint64_t minTimeMs = 500;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a.rfind("--filter=", 0) == 0) filter = a.substr(9);
+        else if (a.rfind("--min-time=", 0) == 0) minTimeMs = strtoull(a.c_str() + 11, nullptr, 10);
+        else if (a == "--json") json = true;
+        else {
+            fprintf(stderr, "uso: %s [--filter=texto] [--min-time=ms] [--json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // nada de log durante as medições, exceto nos casos de log
+    slowlog::setSink(make_unique<NullSink>());
+    slowlog::setLevel(slowlog::Level::Off);
+
+    if (!json) printf("%-32s %12s %10s %10s\n", "# benchmark", "iters", "ns/op", "allocs/op");
+    for (const Case& c : cases()) {
+        if (!filter.empty() && c.name.find(filter) == string::npos) continue;
+        Result r = run(c.name, c.body, minTimeMs * 1000000);
+        if (json)
+            printf("{\"name\":\"%s\",\"iters\":%llu,\"ns_per_op\":%.3f,\"allocs_per_op\":%.3f}\n",
+                   r.name.c_str(), (unsigned long long)r.iters, r.nsPerOp, r.allocsPerOp);
+        else
+            printf("%-32s %12llu %10.2f %10.2f\n", r.name.c_str(), (unsigned long long)r.iters, r.nsPerOp, r.allocsPerOp);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "congestion.h"
+#include "histogram.h"
+#include "log.h"
+#include "metrics.h"
+#include "network.h"
+#include "sender.h"
+#include "session.h"
+#include "session_manager.h"
+#include "slow.h"
+#include "transport.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * @file    slow_loadgen.cpp
+ * @brief   Gerador de carga: N sessões simultâneas contra um servidor SLOW.
+ *
+ * Uso:
+ *   slow_loadgen [--host=ip[:porta]] [--sessions=N] [--duration=s]
+ *                [--rate=msg/s] [--size=B|min-max|exp:média] [--seed=N]
+ *                [--backend=socket|uring] [--cc=reno|cubic] [--impair=perfil]
+ *                [--log=spec] [--metrics-file=arquivo] [--metrics-socket=caminho] [--json]
+ *
+ * Cada sessão roda numa thread com seu próprio Network: handshake com
+ * doThreeWayHandshake e mensagens com Sender::send. Com --rate a carga
+ * é de laço aberto: a latência de cada mensagem conta a partir do
+ * instante em que ela deveria ter saído, então atrasos acumulados
+ * aparecem nos percentis em vez de sumirem (omissão coordenada).
+ * Com --impair cada sessão passa por um ImpairedTransport próprio
+ * (semente deslocada pelo índice da sessão). --metrics-file/--metrics-socket
+ * exportam as métricas do processo (todas as threads) durante a carga.
+ */
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+uint64_t sinceNs(Clock::time_point t) {
+    return uint64_t(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - t).count());
+}
+
+/**
+ * @brief Distribuição dos tamanhos de mensagem.
+ */
+struct SizeDist {
+    enum Kind { Fixed, Uniform, Exp } kind = Fixed;
+    size_t a = 1000, b = 1000; // Fixed: a; Uniform: [a, b]; Exp: média a
+
+    bool parse(const string& s) {
+        char* end;
+        if (s.rfind("exp:", 0) == 0) {
+            kind = Exp;
+            a = strtoull(s.c_str() + 4, &end, 10);
+            return !*end && a;
+        }
+        size_t dash = s.find('-');
+        a = strtoull(s.c_str(), &end, 10);
+        if (dash == string::npos) { kind = Fixed; b = a; return !*end && a; }
+        kind = Uniform;
+        b = strtoull(s.c_str() + dash + 1, &end, 10);
+        return !*end && a && a <= b;
+    }
+
+    size_t next(mt19937_64& rng, size_t max) const {
+        size_t v = a;
+        if (kind == Uniform) v = uniform_int_distribution<size_t>(a, b)(rng);
+        else if (kind == Exp) v = size_t(exponential_distribution<double>(1.0 / double(a))(rng)) + 1;
+        return min(v, max);
+    }
+};
+
+struct Options {
+    sockaddr_in srv{};
+    int sessions = 10;
+    double duration = 10;
+    double rate = 0; // mensagens/s por sessão; 0 = sem pausa
+    SizeDist size;
+    uint64_t seed = 1;
+    string backend = "socket";
+    string cc = "reno";
+    bool impaired = false;
+    ImpairedTransport::Config imp;
+    bool json = false;
+};
+
+/**
+ * @brief Resultado agregado (as threads juntam o seu no fim).
+ */
+struct Totals {
+    mutex m;
+    Histogram handshake, ack; // ns
+    uint64_t messages = 0, bytes = 0, errors = 0, failed = 0;
+};
+
+void runSession(const Options& o, int idx, const vector<uint8_t>& payload, Clock::time_point deadline, Totals& out) {
+    Histogram hs, ack;
+    uint64_t messages = 0, bytes = 0, errors = 0;
+    bool ok = false;
+
+    Network net;
+    if (!net.createSocket(o.backend) && !net.createSocket()) {
+        lock_guard<mutex> g(out.m);
+        ++out.failed;
+        return;
+    }
+    if (o.impaired) {
+        ImpairedTransport::Config imp = o.imp;
+        imp.seed += uint64_t(idx);
+        net.impair(imp);
+    }
+    net.setCongestionControl(makeCongestionController(o.cc));
+    Session sess;
+    sockaddr_in srv = o.srv;
+
+    auto t0 = Clock::now();
+    if (doThreeWayHandshake(net, srv, sess)) {
+        ok = true;
+        hs.record(sinceNs(t0));
+        Sender tx(net, srv, sess);
+        mt19937_64 rng(o.seed + uint64_t(idx));
+        auto period = o.rate > 0 ? chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / o.rate))
+                                 : Clock::duration::zero();
+        auto due = Clock::now();
+        while (Clock::now() < deadline) {
+            if (o.rate > 0) {
+                if (due >= deadline) break;
+                this_thread::sleep_until(due);
+            }
+            auto start = o.rate > 0 ? due : Clock::now();
+            size_t len = o.size.next(rng, min(payload.size(), tx.maxMessage()));
+            if (tx.send(payload.data(), len)) {
+                ack.record(sinceNs(start));
+                ++messages;
+                bytes += len;
+            } else {
+                ++errors;
+                net.resetFlight(sess);
+            }
+            due += period;
+        }
+        uint32_t last;
+        net.sendPacket(srv, makeDisconnect(sess), last, sess);
+        SlowPacket resp;
+        sockaddr_in from{};
+        net.receivePacket(resp, from, sess);
+    }
+    net.closeSocket();
+
+    lock_guard<mutex> g(out.m);
+    out.handshake.merge(hs);
+    out.ack.merge(ack);
+    out.messages += messages;
+    out.bytes += bytes;
+    out.errors += errors;
+    out.failed += !ok;
+}
+
+void printHist(const char* name, const Histogram& h, bool json) {
+    auto ms = [](uint64_t ns) { return double(ns) / 1e6; };
+    if (json) {
+        printf("\"%s\":{\"count\":%llu,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,"
+               "\"p999_ms\":%.3f,\"max_ms\":%.3f}",
+               name, (unsigned long long)h.count(), h.mean() / 1e6, ms(h.percentile(0.5)), ms(h.percentile(0.9)),
+               ms(h.percentile(0.99)), ms(h.percentile(0.999)), ms(h.max()));
+        return;
+    }
+    printf("%-14s: n=%llu  p50 %.3f  p90 %.3f  p99 %.3f  p999 %.3f  max %.3f  (ms)\n",
+           name, (unsigned long long)h.count(), ms(h.percentile(0.5)), ms(h.percentile(0.9)),
+           ms(h.percentile(0.99)), ms(h.percentile(0.999)), ms(h.max()));
+}
+
+int usage(const char* argv0) {
+    cerr << "uso: " << argv0 << " [--host=ip[:porta]] [--sessions=N] [--duration=s]\n"
+            "       [--rate=msg/s] [--size=B|min-max|exp:média] [--seed=N]\n"
+            "       [--backend=socket|uring] [--cc=reno|cubic] [--impair=perfil]\n"
+            "       [--log=spec] [--metrics-file=arquivo] [--metrics-socket=caminho] [--json]\n";
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    string host = "127.0.0.1";
+    metrics::Exporter::Config mcfg;
+    slowlog::setLevel(slowlog::Level::Warn);
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a.rfind("--host=", 0) == 0) host = a.substr(7);
+        else if (a.rfind("--sessions=", 0) == 0) o.sessions = atoi(a.c_str() + 11);
+        else if (a.rfind("--duration=", 0) == 0) o.duration = atof(a.c_str() + 11);
+        else if (a.rfind("--rate=", 0) == 0) o.rate = atof(a.c_str() + 7);
+        else if (a.rfind("--size=", 0) == 0) { if (!o.size.parse(a.substr(7))) return usage(argv[0]); }
+        else if (a.rfind("--seed=", 0) == 0) o.seed = strtoull(a.c_str() + 7, nullptr, 10);
+        else if (a.rfind("--backend=", 0) == 0) o.backend = a.substr(10);
+        else if (a.rfind("--cc=", 0) == 0) o.cc = a.substr(5);
+        else if (a.rfind("--impair=", 0) == 0) {
+            if (!parseImpairment(a.substr(9), o.imp)) return usage(argv[0]);
+            o.impaired = true;
+        }
+        else if (a.rfind("--log=", 0) == 0) { if (!slowlog::configure(a.substr(6))) return usage(argv[0]); }
+        else if (a.rfind("--metrics-file=", 0) == 0) mcfg.file = a.substr(15);
+        else if (a.rfind("--metrics-socket=", 0) == 0) mcfg.socket = a.substr(17);
+        else if (a == "--json") o.json = true;
+        else return usage(argv[0]);
+    }
+    if (o.sessions < 1 || o.duration <= 0 || !makeCongestionController(o.cc)) return usage(argv[0]);
+    if (!parseAddress(host, o.srv, SLOW_PORT)) return usage(argv[0]);
+    metrics::Exporter exporter;
+    if ((!mcfg.file.empty() || !mcfg.socket.empty()) && !exporter.start(mcfg)) return 1;
+
+    size_t maxLen = o.size.kind == SizeDist::Fixed ? o.size.a : o.size.kind == SizeDist::Uniform ? o.size.b : o.size.a * 20;
+    vector<uint8_t> payload(min<size_t>(maxLen, size_t(MAX_FRAGS) * MAX_DATA));
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = uint8_t('a' + i % 26);
+
+    Totals t;
+    auto start = Clock::now();
+    auto deadline = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(o.duration));
+    vector<thread> threads;
+    threads.reserve(size_t(o.sessions));
+    for (int i = 0; i < o.sessions; ++i)
+        threads.emplace_back(runSession, cref(o), i, cref(payload), deadline, ref(t));
+    for (thread& th : threads) th.join();
+    double secs = double(sinceNs(start)) / 1e9;
+    slowlog::flush();
+
+    double mbps = double(t.bytes) / 1e6 / secs, mps = double(t.messages) / secs;
+    if (o.json) {
+        printf("{\"sessions\":%d,\"failed\":%llu,\"seconds\":%.3f,\"messages\":%llu,\"errors\":%llu,"
+               "\"bytes\":%llu,\"msgs_per_s\":%.1f,\"mb_per_s\":%.3f,",
+               o.sessions, (unsigned long long)t.failed, secs, (unsigned long long)t.messages,
+               (unsigned long long)t.errors, (unsigned long long)t.bytes, mps, mbps);
+        printHist("handshake", t.handshake, true);
+        printf(",");
+        printHist("ack", t.ack, true);
+        printf("}\n");
+    } else {
+        printf("sessões        : %d (%llu falharam no handshake)  backend %s  cc %s\n",
+               o.sessions, (unsigned long long)t.failed, o.backend.c_str(), o.cc.c_str());
+        printf("duração        : %.2f s\n", secs);
+        printf("mensagens      : %llu (%llu erros)  %.1f msg/s\n",
+               (unsigned long long)t.messages, (unsigned long long)t.errors, mps);
+        printf("vazão          : %.3f MB/s\n", mbps);
+        printHist("handshake", t.handshake, false);
+        printHist("ACK mensagem", t.ack, false);
+    }
+    return t.failed == uint64_t(o.sessions) ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+#include "capture.h"
+#include "packet.h"
+#include "transport.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+/**
+ * @file    slow_replay.cpp
+ * @brief   Leitor das capturas do cliente (`--capture`): resumo por
+ *          sessão e reinjeção do tráfego num endpoint local.
+ *
+ * Uso:
+ *   slow_replay [-v] captura.pcap
+ *       RTT, retransmissões e goodput de cada sessão (-v lista os pacotes).
+ *   slow_replay --to=host:porta [--dir=tx|rx] [--speed=N] captura.pcap
+ *       reenvia os datagramas de uma direção com o espaçamento original
+ *       (N vezes mais rápido; --speed=0 sem esperas).
+ */
+
+namespace {
+
+using Sid = array<uint8_t, UUID_SIZE>;
+
+/**
+ * @brief Números de uma sessão, do ponto de vista do cliente capturado.
+ */
+struct Stats {
+    uint64_t first = 0, last = 0;       // ns do primeiro e do último pacote
+    uint64_t txPkts = 0, rxPkts = 0;
+    uint64_t txBytes = 0, rxBytes = 0;  // payload, 1ª transmissão / sem duplicatas
+    uint64_t retx = 0;                  // reenvios de seqnum já transmitido
+    uint64_t rxDup = 0;                 // dados recebidos mais de uma vez
+    uint64_t acked = 0;                 // payload enviado e confirmado
+    uint64_t dataStart = 0, ackEnd = 0; // janela de medição do goodput
+    uint64_t handshakeNs = 0;
+    vector<uint64_t> rtt;               // amostras em ns (Karn)
+
+    struct Sent { uint64_t ns; size_t len; bool retx; };
+    map<uint32_t, Sent> inFlight;       // seqnum -> 1ª transmissão
+    unordered_set<uint32_t> txSeen, rxSeen;
+};
+
+string hex(const Sid& s) {
+    static const char* d = "0123456789abcdef";
+    string out;
+    for (uint8_t b : s) { out += d[b >> 4]; out += d[b & 15]; }
+    return out;
+}
+
+uint64_t peerKey(const sockaddr_in& a) {
+    return (uint64_t(a.sin_addr.s_addr) << 16) | a.sin_port;
+}
+
+/**
+ * @brief Mesmo critério da Network: dados e controle consomem seqnum.
+ */
+bool consumesSeq(const SlowPacket& p) {
+    return !p.data.empty() || (p.flags & (CONNECT | REVIVE));
+}
+
+void onTx(Stats& s, const SlowPacket& p, uint64_t ns) {
+    ++s.txPkts;
+    if (!consumesSeq(p)) return;
+    if (!s.txSeen.insert(p.seqnum).second) {
+        ++s.retx;
+        auto it = s.inFlight.find(p.seqnum);
+        if (it != s.inFlight.end()) it->second.retx = true;
+        return;
+    }
+    if (!p.data.empty()) {
+        s.txBytes += p.data.size();
+        if (!s.dataStart) s.dataStart = ns;
+    }
+    s.inFlight[p.seqnum] = {ns, p.data.size(), false};
+}
+
+/**
+ * @brief ACK cumulativo: confirma tudo até `acknum`; só pacotes nunca
+ *        retransmitidos geram amostra de RTT.
+ */
+void onAck(Stats& s, uint32_t acknum, uint64_t ns) {
+    while (!s.inFlight.empty()) {
+        auto it = s.inFlight.begin();
+        if (int32_t(it->first - acknum) > 0) break;
+        if (!it->second.retx) s.rtt.push_back(ns - it->second.ns);
+        s.acked += it->second.len;
+        if (it->second.len) s.ackEnd = ns;
+        s.inFlight.erase(it);
+    }
+}
+
+void onRx(Stats& s, const SlowPacket& p, uint64_t ns) {
+    ++s.rxPkts;
+    if (p.flags & (ACK | ACCEPT)) onAck(s, p.acknum, ns);
+    if (p.data.empty() || (p.flags & (CONNECT | REVIVE | ACCEPT))) return;
+    if (s.rxSeen.insert(p.seqnum).second) s.rxBytes += p.data.size();
+    else ++s.rxDup;
+}
+
+void printPacket(const CaptureReader::Entry& e, const SlowPacket& p, uint64_t t0) {
+    printf("%12.6f %s %-20s seq=%-10u ack=%-10u win=%-5u fid/fo=%u/%u len=%zu\n",
+           double(e.ns - t0) / 1e9, e.dir == Capture::Tx ? "TX" : "RX",
+           flagsToString(p.flags).c_str(), p.seqnum, p.acknum, p.window,
+           p.fid, p.fo, p.data.size());
+}
+
+void report(const map<Sid, Stats>& sessions, uint64_t records, uint64_t malformed) {
+    printf("%llu registros, %llu malformados, %zu sessões\n",
+           (unsigned long long)records, (unsigned long long)malformed, sessions.size());
+    for (const auto& [sid, s] : sessions) {
+        printf("\nsessão %s\n", hex(sid).c_str());
+        printf("  duração     : %.3f s\n", double(s.last - s.first) / 1e9);
+        if (s.handshakeNs) printf("  handshake   : %.3f ms\n", double(s.handshakeNs) / 1e6);
+        printf("  pacotes     : %llu TX, %llu RX\n",
+               (unsigned long long)s.txPkts, (unsigned long long)s.rxPkts);
+        printf("  dados       : %llu B enviados (%llu confirmados), %llu B recebidos (%llu dup)\n",
+               (unsigned long long)s.txBytes, (unsigned long long)s.acked,
+               (unsigned long long)s.rxBytes, (unsigned long long)s.rxDup);
+        printf("  retransm.   : %llu", (unsigned long long)s.retx);
+        uint64_t seqs = s.txSeen.size();
+        if (seqs) printf(" (%.2f%% dos seqnums)", 100.0 * double(s.retx) / double(seqs));
+        printf("\n");
+        if (!s.rtt.empty()) {
+            vector<uint64_t> v = s.rtt;
+            sort(v.begin(), v.end());
+            uint64_t sum = 0;
+            for (uint64_t x : v) sum += x;
+            printf("  RTT (ms)    : min %.3f  med %.3f  avg %.3f  max %.3f  (%zu amostras)\n",
+                   double(v.front()) / 1e6, double(v[v.size() / 2]) / 1e6,
+                   double(sum) / double(v.size()) / 1e6, double(v.back()) / 1e6, v.size());
+        }
+        if (s.ackEnd > s.dataStart && s.acked)
+            printf("  goodput     : %.3f MB/s\n", double(s.acked) * 1e3 / double(s.ackEnd - s.dataStart));
+    }
+}
+
+int analyze(CaptureReader& in, bool verbose) {
+    map<Sid, Stats> sessions;
+    map<uint64_t, uint64_t> connecting; // peer -> ns do CONNECT sem SID
+    CaptureReader::Entry e;
+    SlowPacket p;
+    uint64_t records = 0, malformed = 0, t0 = 0;
+    const Sid nil{};
+    while (in.next(e)) {
+        if (!records++) t0 = e.ns;
+        if (e.len < size_t(HDR_SIZE)) { ++malformed; continue; }
+        p.deserialize(e.data, e.len);
+        if (verbose) printPacket(e, p, t0);
+
+        // o CONNECT ainda não tem SID: a sessão nasce no ACCEPT
+        if (p.sid == nil) {
+            if (e.dir == Capture::Tx && (p.flags & CONNECT)) connecting.emplace(peerKey(e.peer), e.ns);
+            continue;
+        }
+        Stats& s = sessions[p.sid];
+        if (!s.first) s.first = e.ns;
+        s.last = e.ns;
+        if (e.dir == Capture::Rx && (p.flags & ACCEPT)) {
+            auto it = connecting.find(peerKey(e.peer));
+            if (it != connecting.end()) {
+                s.first = it->second;
+                s.handshakeNs = e.ns - it->second;
+                ++s.txPkts;
+                connecting.erase(it);
+            }
+        }
+        if (e.dir == Capture::Tx) onTx(s, p, e.ns);
+        else onRx(s, p, e.ns);
+    }
+    report(sessions, records, malformed);
+    return 0;
+}
+
+/**
+ * @brief Reenvia os datagramas de uma direção para `to`, mantendo o
+ *        espaçamento original dividido por `speed`. Respostas são lidas
+ *        e contadas, para não encher o buffer do socket.
+ */
+int replay(CaptureReader& in, const sockaddr_in& to, Capture::Dir dir, double speed) {
+    UdpTransport io;
+    if (!io.open()) { cerr << "socket() erro\n"; return 1; }
+    CaptureReader::Entry e;
+    Datagram rx[UdpTransport::BATCH];
+    uint64_t sent = 0, replies = 0, t0 = 0;
+    auto start = chrono::steady_clock::now();
+    while (in.next(e)) {
+        if (e.dir != dir) continue;
+        if (!sent) t0 = e.ns;
+        if (speed > 0) this_thread::sleep_until(start + chrono::nanoseconds(uint64_t(double(e.ns - t0) / speed)));
+        OutDatagram d;
+        d.iov[0] = {const_cast<uint8_t*>(e.data), e.len};
+        sent += io.send(to, &d, 1);
+        replies += io.recv(rx, UdpTransport::BATCH);
+    }
+    // respostas aos últimos pacotes
+    while (io.wait(200)) replies += io.recv(rx, UdpTransport::BATCH);
+    printf("%llu datagramas reenviados, %llu respostas\n",
+           (unsigned long long)sent, (unsigned long long)replies);
+    return 0;
+}
+
+int usage(const char* argv0) {
+    cerr << "uso: " << argv0 << " [-v] captura.pcap\n"
+            "       " << argv0 << " --to=host:porta [--dir=tx|rx] [--speed=N] captura.pcap\n";
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    string path, target;
+    Capture::Dir dir = Capture::Tx;
+    double speed = 1;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "-v") verbose = true;
+        else if (a.rfind("--to=", 0) == 0) target = a.substr(5);
+        else if (a == "--dir=tx") dir = Capture::Tx;
+        else if (a == "--dir=rx") dir = Capture::Rx;
+        else if (a.rfind("--speed=", 0) == 0) speed = atof(a.c_str() + 8);
+        else if (a[0] != '-' && path.empty()) path = a;
+        else return usage(argv[0]);
+    }
+    if (path.empty()) return usage(argv[0]);
+
+    CaptureReader in;
+    if (!in.open(path.c_str())) {
+        cerr << "[erro] " << path << ": não é uma captura do cliente SLOW\n";
+        return 1;
+    }
+    if (target.empty()) return analyze(in, verbose);
+
+    sockaddr_in to;
+    if (!parseAddress(target, to, SLOW_PORT)) return usage(argv[0]);
+    return replay(in, to, dir, speed);
+}
@@ -0,0 +1,101 @@
+#include "network.h"
+#include "server.h"
+#include "slow.h"
+#include "transport.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+using namespace std;
+
+/**
+ * @file    slow_server.cpp
+ * @brief   Servidor SLOW local para testes e benchmarks sem o servidor público.
+ *
+ * Uso:
+ *   slow_server [--bind=ip[:porta]] [--window=B] [--sttl=ms]
+ *               [--backend=socket|uring] [--stats=s]
+ *
+ * Escuta em 127.0.0.1:7033 por padrão; o cliente aponta para ele com
+ * `--host=127.0.0.1`. Com --stats, imprime os contadores a cada s
+ * segundos; no Ctrl-C imprime o total.
+ */
+
+namespace {
+
+volatile sig_atomic_t stopping = 0;
+
+void onSignal(int) { stopping = 1; }
+
+void printStats(const SlowServer& srv) {
+    const SlowServer::Counters& c = srv.counters();
+    printf("[server] sessões %zu (abertas %zu)  rx %llu  tx %llu  dados %llu B  msgs %llu  dup %llu"
+           "  aceitas %llu  revividas %llu  fechadas %llu  expiradas %llu  desconhecidos %llu\n",
+           srv.sessions(), srv.openSessions(),
+           (unsigned long long)c.rxPackets, (unsigned long long)c.txPackets,
+           (unsigned long long)c.dataBytes, (unsigned long long)c.messages,
+           (unsigned long long)c.duplicates, (unsigned long long)c.accepted,
+           (unsigned long long)c.revived, (unsigned long long)c.closed,
+           (unsigned long long)c.expired, (unsigned long long)c.unknown);
+    fflush(stdout);
+}
+
+int usage(const char* argv0) {
+    cerr << "uso: " << argv0 << " [--bind=ip[:porta]] [--window=B] [--sttl=ms]\n"
+            "       [--backend=socket|uring] [--stats=s]\n";
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string bind = "127.0.0.1", backend = "socket";
+    SlowServer::Config cfg;
+    uint64_t statsMs = 0;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a.rfind("--bind=", 0) == 0) bind = a.substr(7);
+        else if (a.rfind("--window=", 0) == 0) cfg.window = uint16_t(min(strtoul(a.c_str() + 9, nullptr, 10), 65535ul));
+        else if (a.rfind("--sttl=", 0) == 0) cfg.sttlMs = uint32_t(strtoul(a.c_str() + 7, nullptr, 10));
+        else if (a.rfind("--backend=", 0) == 0) backend = a.substr(10);
+        else if (a.rfind("--stats=", 0) == 0) statsMs = strtoull(a.c_str() + 8, nullptr, 10) * 1000;
+        else return usage(argv[0]);
+    }
+    // o STTL viaja em 27 bits
+    if (!cfg.sttlMs || cfg.sttlMs >= (1u << 27)) return usage(argv[0]);
+
+    sockaddr_in local;
+    if (!parseAddress(bind, local, SLOW_PORT)) return usage(argv[0]);
+    shared_ptr<Transport> io = makeTransport(backend);
+    if (!io || !io->open()) {
+        cerr << "[io] backend '" << backend << "' indisponível, usando socket\n";
+        io = makeTransport("socket");
+        if (!io->open()) { cerr << "socket() erro\n"; return 1; }
+    }
+    // milhares de sessões em rajada: buffers do kernel bem maiores que o padrão
+    int sz = 8 << 20;
+    setsockopt(io->fd(), SOL_SOCKET, SO_RCVBUF, &sz, sizeof sz);
+    setsockopt(io->fd(), SOL_SOCKET, SO_SNDBUF, &sz, sizeof sz);
+    if (!io->bind(local)) { perror("bind"); return 1; }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    SlowServer srv(io, cfg);
+    printf("[server] %s, backend %s, janela %u B, STTL %u ms\n",
+           bind.c_str(), io->name(), cfg.window, cfg.sttlMs);
+    fflush(stdout);
+
+    uint64_t nextStats = statsMs ? nowMs() + statsMs : 0;
+    while (!stopping) {
+        srv.runOnce(100);
+        if (nextStats && nowMs() >= nextStats) {
+            printStats(srv);
+            nextStats += statsMs;
+        }
+    }
+    printStats(srv);
+    io->close();
+    return 0;
+}
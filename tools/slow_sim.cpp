@@ -0,0 +1,276 @@
+#include "congestion.h"
+#include "event_loop.h"
+#include "histogram.h"
+#include "impairment.h"
+#include "log.h"
+#include "server.h"
+#include "session.h"
+#include "simulator.h"
+#include "slow.h"
+#include "transport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+using namespace std;
+
+/**
+ * @file    slow_sim.cpp
+ * @brief   Simulador determinístico: EventLoop real contra o SlowServer
+ *          real, ligados por enlaces simulados num relógio virtual.
+ *
+ * Uso:
+ *   slow_sim [--sessions=N] [--duration=s] [--rate=msg/s] [--size=B|min-max]
+ *            [--bw=bits/s] [--rtt=ms] [--loss=p] [--impair=perfil]
+ *            [--cc=reno|cubic] [--window=B] [--sttl=ms] [--no-keepalive]
+ *            [--seed=N] [--log=spec] [--json]
+ *
+ * --bw, --rtt e --loss valem para os dois sentidos (o atraso de cada um
+ * é metade do RTT); --impair ajusta o resto no formato de --impair do
+ * cliente, com "tx." = cliente → servidor e "rx." = servidor → cliente.
+ * Sem --rate cada sessão mantém sempre uma mensagem na fila (envio
+ * contínuo). --duration é tempo virtual; a mesma semente reproduz os
+ * mesmos números. Com --rate baixo e --sttl curto as sessões ficam
+ * ociosas entre mensagens, o que exercita os keep-alives do EventLoop
+ * (--no-keepalive os desliga, para comparar expirações e revives).
+ */
+
+namespace {
+
+struct Options {
+    int sessions = 10;
+    double duration = 60;
+    double rate = 0;
+    size_t sizeMin = 1000, sizeMax = 1000;
+    string cc = "reno";
+    uint16_t window = UINT16_MAX;
+    uint32_t sttl = 0; // 0 = padrão do servidor
+    bool keepAlive = true;
+    uint64_t seed = 1;
+    bool json = false;
+};
+
+/**
+ * @brief Estado de uma sessão simulada (Connection::user).
+ */
+struct Flow {
+    mt19937_64 rng;
+    deque<uint64_t> queued; // µs em que cada mensagem da fila entrou
+    bool open = false;
+};
+
+struct Totals {
+    Histogram handshake, latency; // µs virtuais
+    uint64_t messages = 0, bytes = 0, opened = 0, closed = 0, aborted = 0;
+};
+
+bool parseSize(const string& s, Options& o) {
+    char* end;
+    o.sizeMin = strtoull(s.c_str(), &end, 10);
+    o.sizeMax = o.sizeMin;
+    if (*end == '-') o.sizeMax = strtoull(end + 1, &end, 10);
+    return !*end && o.sizeMin && o.sizeMin <= o.sizeMax;
+}
+
+void printHist(const char* name, const Histogram& h, bool json) {
+    auto ms = [](uint64_t us) { return double(us) / 1e3; };
+    if (json) {
+        printf("\"%s\":{\"count\":%llu,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}",
+               name, (unsigned long long)h.count(), ms(h.percentile(0.5)), ms(h.percentile(0.9)),
+               ms(h.percentile(0.99)), ms(h.max()));
+        return;
+    }
+    printf("%-14s: n=%llu  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f  (ms)\n",
+           name, (unsigned long long)h.count(), ms(h.percentile(0.5)), ms(h.percentile(0.9)),
+           ms(h.percentile(0.99)), ms(h.max()));
+}
+
+void printLink(const char* name, const ImpairedLink& l, bool json) {
+    const ImpairedLink::Counters& c = l.counters();
+    if (json) {
+        printf("\"%s\":{\"passed\":%llu,\"lost\":%llu,\"duplicated\":%llu,\"reordered\":%llu,\"overflow\":%llu}",
+               name, (unsigned long long)c.passed, (unsigned long long)c.lost, (unsigned long long)c.duplicated,
+               (unsigned long long)c.reordered, (unsigned long long)c.overflow);
+        return;
+    }
+    printf("%-14s: %llu passaram  %llu perdidos  %llu duplicados  %llu reordenados  %llu fila cheia\n",
+           name, (unsigned long long)c.passed, (unsigned long long)c.lost, (unsigned long long)c.duplicated,
+           (unsigned long long)c.reordered, (unsigned long long)c.overflow);
+}
+
+int usage(const char* argv0) {
+    cerr << "uso: " << argv0 << " [--sessions=N] [--duration=s] [--rate=msg/s] [--size=B|min-max]\n"
+            "       [--bw=bits/s] [--rtt=ms] [--loss=p] [--impair=perfil]\n"
+            "       [--cc=reno|cubic] [--window=B] [--sttl=ms] [--no-keepalive]\n"
+            "       [--seed=N] [--log=spec] [--json]\n";
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    ImpairedTransport::Config link;
+    link.tx.rateBps = link.rx.rateBps = 10000000;
+    link.tx.delayUs = link.rx.delayUs = 20000;
+    string impair;
+    slowlog::setLevel(slowlog::Level::Warn);
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a.rfind("--sessions=", 0) == 0) o.sessions = atoi(a.c_str() + 11);
+        else if (a.rfind("--duration=", 0) == 0) o.duration = atof(a.c_str() + 11);
+        else if (a.rfind("--rate=", 0) == 0) o.rate = atof(a.c_str() + 7);
+        else if (a.rfind("--size=", 0) == 0) { if (!parseSize(a.substr(7), o)) return usage(argv[0]); }
+        else if (a.rfind("--bw=", 0) == 0) { if (!parseImpairment("rate=" + a.substr(5), link)) return usage(argv[0]); }
+        else if (a.rfind("--rtt=", 0) == 0) link.tx.delayUs = link.rx.delayUs = uint64_t(atof(a.c_str() + 6) * 500);
+        else if (a.rfind("--loss=", 0) == 0) { if (!parseImpairment("loss=" + a.substr(7), link)) return usage(argv[0]); }
+        else if (a.rfind("--impair=", 0) == 0) impair = a.substr(9);
+        else if (a.rfind("--cc=", 0) == 0) o.cc = a.substr(5);
+        else if (a.rfind("--window=", 0) == 0) o.window = uint16_t(min(strtoul(a.c_str() + 9, nullptr, 10), 65535ul));
+        else if (a.rfind("--sttl=", 0) == 0) o.sttl = uint32_t(strtoul(a.c_str() + 7, nullptr, 10));
+        else if (a == "--no-keepalive") o.keepAlive = false;
+        else if (a.rfind("--seed=", 0) == 0) o.seed = strtoull(a.c_str() + 7, nullptr, 10);
+        else if (a.rfind("--log=", 0) == 0) { if (!slowlog::configure(a.substr(6))) return usage(argv[0]); }
+        else if (a == "--json") o.json = true;
+        else return usage(argv[0]);
+    }
+    // --impair por último, para refinar o que --bw/--rtt/--loss fixaram
+    if (!impair.empty() && !parseImpairment(impair, link)) return usage(argv[0]);
+    if (o.sessions < 1 || o.duration <= 0 || o.rate < 0 || !makeCongestionController(o.cc)) return usage(argv[0]);
+    o.sizeMax = min<size_t>(o.sizeMax, size_t(MAX_FRAGS) * MAX_DATA);
+    o.sizeMin = min(o.sizeMin, o.sizeMax);
+
+    Simulator sim(o.seed);
+    Session::seedUUID(o.seed); // FIDs do Sender
+
+    sockaddr_in cli{}, srvAddr{};
+    parseAddress("10.0.0.1:40000", cli, 0);
+    parseAddress("10.0.0.2", srvAddr, SLOW_PORT);
+    auto up = sim.endpoint(cli, link.tx);
+    auto down = sim.endpoint(srvAddr, link.rx);
+
+    SlowServer::Config scfg;
+    scfg.window = o.window;
+    scfg.seed = o.seed;
+    if (o.sttl) scfg.sttlMs = o.sttl;
+    SlowServer server(down, scfg);
+    EventLoop loop(srvAddr);
+    loop.attach(up);
+    loop.setKeepAlive(o.keepAlive);
+    sim.addNode([&] { return server.nextDeadline(); }, [&] { server.runOnce(0); });
+    sim.addNode([&] { return loop.nextDeadline(); }, [&] { loop.poll(sim.nowMs()); });
+
+    vector<uint8_t> payload(o.sizeMax);
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = uint8_t('a' + i % 26);
+
+    Totals t;
+    bool running = true;
+    uint64_t start = sim.nowUs();
+    uint64_t endMs = sim.nowMs() + uint64_t(o.duration * 1000);
+    vector<unique_ptr<Flow>> flows;
+    vector<Connection*> conns;
+
+    auto enqueue = [&](Connection& c) {
+        Flow& f = *static_cast<Flow*>(c.user);
+        size_t len = uniform_int_distribution<size_t>(o.sizeMin, o.sizeMax)(f.rng);
+        f.queued.push_back(sim.nowUs());
+        loop.send(c, vector<uint8_t>(payload.begin(), payload.begin() + ptrdiff_t(len)));
+    };
+
+    Connection::Handlers h;
+    h.onOpen = [&](Connection& c) {
+        Flow& f = *static_cast<Flow*>(c.user);
+        if (f.open) return; // só o handshake conta (não há revive aqui)
+        f.open = true;
+        ++t.opened;
+        t.handshake.record(sim.nowUs() - start);
+        // envio contínuo: uma mensagem em curso e outra já na fila
+        if (o.rate <= 0) { enqueue(c); enqueue(c); }
+    };
+    h.onSent = [&](Connection& c, size_t n) {
+        Flow& f = *static_cast<Flow*>(c.user);
+        t.latency.record(sim.nowUs() - f.queued.front());
+        f.queued.pop_front();
+        ++t.messages;
+        t.bytes += n;
+        if (running && o.rate <= 0) enqueue(c);
+    };
+    h.onClosed = [&](Connection&, bool graceful) { ++(graceful ? t.closed : t.aborted); };
+
+    for (int i = 0; i < o.sessions; ++i) {
+        flows.push_back(make_unique<Flow>());
+        flows.back()->rng.seed(o.seed + uint64_t(i));
+        Connection* c = loop.connect(h);
+        c->user = flows.back().get();
+        c->net.setCongestionControl(makeCongestionController(o.cc));
+        conns.push_back(c);
+    }
+    // --rate: chegadas periódicas por sessão, cada uma com sua fase
+    double period = o.rate > 0 ? 1000.0 / o.rate : 0;
+    function<void(Connection*, double)> tick = [&](Connection* c, double when) {
+        if (!running) return;
+        if (c->state == Connection::State::Open) enqueue(*c);
+        double next = when + period;
+        sim.at(uint64_t(next), [&tick, c, next] { tick(c, next); });
+    };
+    if (o.rate > 0)
+        for (Connection* c : conns) {
+            Flow& f = *static_cast<Flow*>(c->user);
+            double first = double(sim.nowMs()) + uniform_real_distribution<double>(0, period)(f.rng);
+            sim.at(uint64_t(first), [&tick, c, first] { tick(c, first); });
+        }
+
+    auto wall = chrono::steady_clock::now();
+    sim.runUntil(endMs);
+    running = false;
+    uint64_t elapsedUs = sim.nowUs() - start;
+    for (Connection* c : conns) loop.disconnect(*c);
+    sim.runUntil(endMs + EventLoop::STATE_TIMEOUT_MS);
+    double wallSecs = chrono::duration<double>(chrono::steady_clock::now() - wall).count();
+    slowlog::flush();
+
+    double secs = double(elapsedUs) / 1e6;
+    double mbps = double(t.bytes) * 8 / 1e6 / secs;
+    const SlowServer::Counters& sc = server.counters();
+    if (o.json) {
+        printf("{\"seed\":%llu,\"sessions\":%d,\"opened\":%llu,\"closed\":%llu,\"aborted\":%llu,"
+               "\"virtual_s\":%.3f,\"events\":%llu,\"messages\":%llu,\"bytes\":%llu,\"goodput_mbps\":%.3f,"
+               "\"server_duplicates\":%llu,\"server_expired\":%llu,\"server_revived\":%llu,",
+               (unsigned long long)o.seed, o.sessions, (unsigned long long)t.opened,
+               (unsigned long long)t.closed, (unsigned long long)t.aborted, secs,
+               (unsigned long long)sim.events(), (unsigned long long)t.messages,
+               (unsigned long long)t.bytes, mbps, (unsigned long long)sc.duplicates,
+               (unsigned long long)sc.expired, (unsigned long long)sc.revived);
+        printHist("handshake", t.handshake, true);
+        printf(",");
+        printHist("message", t.latency, true);
+        printf(",");
+        printLink("up", up->link(), true);
+        printf(",");
+        printLink("down", down->link(), true);
+        printf(",\"wall_s\":%.3f}\n", wallSecs);
+    } else {
+        printf("sessões        : %d (%llu abertas, %llu encerradas, %llu abortadas)  cc %s  semente %llu\n",
+               o.sessions, (unsigned long long)t.opened, (unsigned long long)t.closed,
+               (unsigned long long)t.aborted, o.cc.c_str(), (unsigned long long)o.seed);
+        printf("tempo virtual  : %.1f s em %.2f s reais (%.0fx, %llu eventos)\n",
+               secs, wallSecs, secs / max(wallSecs, 1e-9), (unsigned long long)sim.events());
+        printf("mensagens      : %llu  %.3f Mbit/s úteis  (%llu duplicadas no servidor)\n",
+               (unsigned long long)t.messages, mbps, (unsigned long long)sc.duplicates);
+        printf("servidor       : %llu sessões expiradas, %llu revividas\n",
+               (unsigned long long)sc.expired, (unsigned long long)sc.revived);
+        printHist("handshake", t.handshake, false);
+        printHist("mensagem", t.latency, false);
+        printLink("enlace ida", up->link(), false);
+        printLink("enlace volta", down->link(), false);
+    }
+    return t.opened ? 0 : 1;
+}